@@ -313,4 +313,196 @@ next i
 m[1,2,3,4,5,6]=999
 if (999 <> m[1,2,3,4,5,6]) then
   throw "e"
-endif
\ No newline at end of file
+endif
+rem --- numeric arrays created by DIM
+dim pk(1 to 4)
+pk(1) = 10
+pk(2) += 5
+pk(3) = pk(1) * pk(2)
+if (pk(3) != 50 || pk(4) != 0) then throw "packed int error"
+pk(4) = 0.5
+if (pk(4) != 0.5 || pk(3) != 50) then throw "packed num error"
+pk2 = pk
+pk2(1) = "s"
+if (pk(1) != 10 || pk2(1) != "s") then throw "packed copy error"
+redim pk(1 to 6)
+if (pk(6) != 0 || pk(3) != 50) then throw "packed redim error"
+dim pk3(2, 2)
+pk3(1, 2) = 7
+pk3(2, 2).x = 1
+if (pk3(1, 2) != 7 || pk3(2, 2).x != 1) then throw "packed matrix error"
+rem --- SEARCH modes
+func cmp_len(x, y)
+  cmp_len = len(x) - len(y)
+end
+dim sk(1 to 100)
+for i = 1 to 100
+  sk(i) = i * 3
+next i
+for mode = 0 to 2
+  search sk, 30, r, mode
+  if (r != 10) then throw "search found error " + mode
+  search sk, 31, r, mode
+  if (r != 0) then throw "search missing error " + mode
+next mode
+search sk, 300, r, 1
+if (r != 100) then throw "search sorted last error"
+sk(50) = 30
+search sk, 30, r, 2
+if (r != 10) then throw "search hash first error"
+ss = ["pear", "apple", "fig", "apple", "kiwi"]
+search ss, "apple", r, 2
+if (r != 1) then throw "search hash str error"
+search ss, "plum", r, 2
+if (r != -1) then throw "search hash str missing error"
+ss(4) = "plum"
+search ss, "plum", r, 2
+if (r != 4) then throw "search hash stale error"
+ss(0) = "kiwi"
+search ss, "kiwi", r, 2
+if (r != 0) then throw "search hash stale first error"
+ss(1) = 1: ss(3) = 2
+search ss, "apple", r, 2
+if (r != -1) then throw "search hash type error"
+search sk, 33, r, 2
+sk(11) = 34
+search sk, 34, r, 2
+if (r != 11) then throw "search hash stale int error"
+sk(10) = 1.5
+search sk, 34, r, 2
+if (r != 11) then throw "search hash stale type error"
+sort ss
+search ss, "kiwi", r, 1
+if (r != 3) then throw "search sorted str error"
+sl = ["a", "bb", "ccc", "dddd"]
+search sl, "xyz", r, 1 use cmp_len(x, y)
+if (r != 2) then throw "search sorted use error"
+search sl, "xy", r, 2 use cmp_len(x, y)
+if (r != 1) then throw "search hash use error"
+rem --- copy on write
+func cow_fill(n)
+  local r
+  dim r(1 to n)
+  for i = 1 to n
+    r(i) = i
+  next i
+  cow_fill = r
+end
+sub cow_change(x)
+  x(1) = -1
+end
+sub cow_ref(byref e)
+  cw = cwa
+  e = "ref"
+end
+cwa = cow_fill(5)
+cwb = cwa
+cwb(1) = 10
+if (cwa(1) != 1 || cwb(1) != 10) then throw "cow assign error"
+cwb = cwa
+cwa(2) = 20
+if (cwb(2) != 2 || cwa(2) != 20) then throw "cow source error"
+cow_change(cwa)
+if (cwa(1) != 1) then throw "cow byval error"
+cwb = cwa
+cwb << 6
+if (len(cwa) != 5 || len(cwb) != 6) then throw "cow append error"
+cwa(1) = cwa
+if (len(cwa(1)) != 5 || cwa(1)(1) != 1 || cwa(1)(2) != 20) then throw "cow self error"
+cwk = [1, 2, 3]
+cwk(1) = cwk
+cwk(1)(1) = cwk
+if (cwk(1)(1)(1)(0) != 1 || cwk(1)(1)(1)(1) != 2) then throw "cow nested self error"
+cwn = [[1, 2], [3, 4]]
+cwm = cwn
+cwm(1)(0) = 5
+if (cwn(1)(0) != 3 || cwm(1)(0) != 5) then throw "cow nested error"
+dim cwp(1 to 3)
+cwp(1) = 7
+cwq = cwp
+cwq(1) = 8.5
+if (cwp(1) != 7 || cwq(1) != 8.5) then throw "cow packed error"
+cws = "text"
+cwt = cws
+cws += "s"
+if (cwt != "text" || cws != "texts") then throw "cow string error"
+cwa = [1, 2, 3]
+cow_ref(cwa(1))
+if (cwa(1) != "ref" || cw(1) != 2) then throw "cow byref error"
+dim cwb(1 to 3)
+cwc = cwb
+redim cwc(2 to 4)
+if (lbound(cwb) != 1 || ubound(cwb) != 3 || lbound(cwc) != 2 || ubound(cwc) != 4) then throw "cow bounds error"
+sub pk_byval(v)
+  v = "changed"
+end
+func pk_read(byref a)
+  local x, s, j
+  for x in a
+    s += x
+  next
+  s += len(a(1)) + isnumber(a(1)) + empty(a(1)) + max(a) + sum(a) + statmean(a)
+  join a, ",", j
+  s += len(j) + (2 in a) + (a = a)
+  pk_byval(a(1))
+  pk_read = s
+end
+' a 2^53+1 integer is kept when a real is stored in the packed array
+pkn = &H20000000000000
+dim pka(2)
+pka(1) = &H20000000000001
+pk_read(pka)
+pka(0) = 1.5
+if (pka(1) - pkn != 1 || pka(0) != 1.5) then throw "packed widen error"
+dim pkc(2)
+pkc(1) = 3
+pkc(0) = 0.5
+if (pkc(1) != 3 || pkc(0) != 0.5 || pkc(2) != 0) then throw "packed widen exact error"
+dim pkb(2)
+pkb(1) = &H20000000000001
+pkb(2) = "text"
+pkb(0) = 1.5
+if (pkb(1) - pkn != 1) then throw "packed write error"
+' sorting
+func sr_str(a)
+  local s
+  join a, "", s
+  sr_str = s
+end
+dim sri(20)
+for i = 0 to 20
+  sri(i) = (i * 7919) mod 23 - 11
+next
+sort sri
+for i = 1 to 20
+  if (sri(i - 1) > sri(i)) then throw "sort packed int error"
+next
+dim srn(3)
+srn(0) = 2.5: srn(1) = -0.5: srn(2) = -3.25: srn(3) = 0
+sort srn
+if (srn(0) != -3.25 || srn(1) != -0.5 || srn(2) != 0 || srn(3) != 2.5) then throw "sort packed num error"
+srs = ["k", "c", "a", "j", "e", "b", "i", "d", "h", "f", "g", 3, 1.5]
+sort srs
+if (sr_str(srs) != "1.53abcdefghijk") then throw "sort mixed error"
+func sr_key(x, y)
+  sr_key = iff(x(0) == y(0), 0, iff(x(0) < y(0), -1, 1))
+end
+srp = []
+for i = 0 to 19
+  srp << [i mod 3, i]
+next
+sort srp use sr_key(x, y)
+for i = 1 to 19
+  if (srp(i - 1)(0) > srp(i)(0)) then throw "sort use error"
+  if (srp(i - 1)(0) == srp(i)(0) && srp(i - 1)(1) > srp(i)(1)) then throw "sort stable error"
+next
+srd = [3, 1, 2, 5, 4]
+sort srd use y - x
+if (sr_str(srd) != "54321") then throw "sort use desc error"
+func sr_peek(x, y)
+  local c = srg
+  sr_peek = x - y + c(0) * 0
+end
+srg = [3, 1, 2]
+sort srg use sr_peek(x, y)
+if (sr_str(srg) != "123") then throw "sort use read error"
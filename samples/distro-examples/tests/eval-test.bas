@@ -362,6 +362,31 @@ moves_called = false
 for i in s.moves()
 next i  
 
+rem constant sub-expressions, increments and single operand expressions
+if (2 * 3 + 1 != 7 or -2 ^ 2 != 4 or 2 - -3 != 5 or 7 / 2 != 3.5) then throw "fold error"
+if (str(1 + 2) != "3" or str(0.5 + 0.25) != "0.75" or str(-(1.5)) != "-1.5") then throw "fold error"
+try
+  n = 1 / 0
+  throw "no division by zero"
+catch e
+end try
+n = 1
+n = n + 1
+n = n - 0.5
+if (n != 1.5) then throw "increment error"
+n = "a"
+n = n + 1
+if (n != "a1") then throw "increment error"
+a$ = "x"
+b$ = a$ + "y" + n
+if (b$ != "xya1" or a$ + "" != "x" or !(a$ = "x")) then throw "operand error"
+goto lineskip
+data 1
+label lineskip
+if (progline != 386) then throw "line number error"
+data 2
+if (progline != 388) then throw "line number error"
+
 gg = 99
 gosub plus1
 if (gg != 100) then throw "err"
@@ -0,0 +1,70 @@
+'
+' FOR-TO-NEXT with integer and non-integer bounds
+'
+
+for i=1 to 5
+  print i;
+next
+print
+for i=5 to 1 step -2
+  print i;
+next
+print
+n=4
+for i=1 to n
+  print i;
+  n=2
+next
+print
+for i=1 to 3 step 0.5
+  print i;
+next
+print
+for i=1 to 2.5
+  print i;
+next
+print
+for i=1 to 3
+  if i=2 then i=2.5
+  print i;
+next
+print
+for i=1 to 3
+  for j=1 to 2
+    print i*10+j;
+  next
+next
+print
+i=3
+for i=1 to i
+  print i;
+next
+print i
+s=-1
+for i=3 to 1 step s
+  print i;
+next
+print
+for i=1 to 10
+  if i=4 then exit for
+next
+print i
+sub f(k)
+  local j
+  for j=1 to k
+    print j;
+    if k>1 then f(k-1)
+  next
+end
+f(2)
+print
+for i=1 to 0
+  print "no"
+next
+print i
+for i=1 to 5
+  if i=2 then goto 100
+  print i;
+  label 100
+next
+print
@@ -61,3 +61,19 @@ f.inputs[6].value= "123"
 if (not isarray(f.inputs)) then
   throw "post: inputs not a map"
 endif
+
+### FOR IN visits map keys in insertion order
+m = array("{}")
+for i = 1 to 1000
+  m("key" + i) = i
+next
+n = 0
+s = 0
+for k in m
+  n++
+  s += m(k)
+  if (k != "key" + n) then
+    throw "for-in order: " + k
+  endif
+next
+? n; " "; s
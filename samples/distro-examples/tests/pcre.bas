@@ -0,0 +1,34 @@
+'
+' Tests for OPTION MATCH PCRE, run when built with libpcre
+'
+
+option match pcre
+
+' fails when LIKE has used the wildcard matcher
+if !("rx12" like "^rx1[0-9]$") then throw "pcre not used"
+if ("rx12" like "^rx1$") then throw "pcre anchor error"
+
+' more patterns than the 16 compiled patterns which are cached
+sub match_patterns
+  local i, pass
+  for pass = 1 to 2
+    for i = 1 to 20
+      if !(("rx" + i) like ("^rx" + i + "$")) then throw "pattern cache match error"
+      if (("rx" + i + "0") like ("^rx" + i + "$")) then throw "pattern cache mismatch error"
+    next
+  next
+end
+match_patterns
+
+' the options are part of the cached pattern
+option match pcre caseless
+if !("ABC" like "^abc$") then throw "pcre caseless error"
+option match pcre
+if ("ABC" like "^abc$") then throw "pcre case error"
+
+' the chained task releases the cache when it closes
+chain "option match pcre: if !(\"rx1\" like \"^rx[0-9]$\") then print \"chain pattern error\""
+match_patterns
+if !("ABC" like "^[A-C]+$") then throw "pcre after chain error"
+
+option match simple
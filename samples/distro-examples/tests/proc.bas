@@ -159,3 +159,20 @@ local blah,
 local z,
 blah=1
 z=blah
+
+rem --- locals kept across recursive calls
+func rec_depth(n, s)
+  local a, b, c, d, e, f, g, h
+  a = s + "x"
+  dim h(2)
+  h(1) = n
+  if n = 0 then return len(a)
+  b = rec_depth(n - 1, a)
+  if a != s + "x" then throw "err: " + a
+  if h(1) != n then throw "err: " + h(1)
+  return b
+end
+
+for i = 1 to 5
+  if rec_depth(20 + i * 10, "") != 21 + i * 10 then throw "err: " + i
+next i
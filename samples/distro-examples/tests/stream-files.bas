@@ -30,6 +30,55 @@ WHILE NOT EOF(F)
 WEND
 CLOSE #F
 
+'' CRLF line endings, SEEK and LOF while reading
+OPEN "test.dat" FOR OUTPUT AS #F
+PRINT #F, "first" + CHR(13)
+PRINT #F, "second";
+CLOSE #F
+OPEN "test.dat" FOR INPUT AS #F
+LINEINPUT #F, a$
+PRINT "NL=[";a$;"] SEEK=";SEEK(F);" LOF=";LOF(F)
+LINEINPUT #F, a$
+PRINT "NL=[";a$;"] EOF=";EOF(F)
+SEEK #F, 2
+LINEINPUT #F, a$
+PRINT "NL=[";a$;"]"
+CLOSE #F
+
+'' TLOAD lines, from a file name and the remainder of an open file
+TLOAD "test.dat", lines
+PRINT "TLOAD=";LEN(lines);" [";lines[0];"] [";lines[1];"]"
+OPEN "test.dat" FOR INPUT AS #F
+LINEINPUT #F, a$
+TLOAD #F, lines
+PRINT "TLOAD=";LEN(lines);" [";lines[0];"] EOF=";EOF(F)
+CLOSE #F
+
+'' maps written to a file in blocks
+m = {}
+FOR i = 1 TO 500
+  m["key" + i] = [i, "v" + i]
+NEXT
+OPEN "test.dat" FOR OUTPUT AS #F
+PRINT #F, m
+CLOSE #F
+TLOAD "test.dat", lines
+IF (lines[0] != str(m)) THEN THROW "map write error"
+
+'' JSON parsed from a file in blocks
+q = chr(34)
+OPEN "test.dat" FOR OUTPUT AS #F
+PRINT #F, "{";
+FOR i = 1 TO 2000
+  PRINT #F, q; "key"; i; q; ":["; i; ","; q; "value "; i; q; ",{"; q; "n"; q; ":"; i; "}],"
+NEXT
+PRINT #F, q; "last"; q; ":[1,2;3,4]}"
+CLOSE #F
+TLOAD "test.dat", text, 1
+TLOAD "test.dat", m, 2
+IF (str(m) != str(array(text))) THEN THROW "json read error"
+IF (m.key1999(1) != "value 1999" OR str(m.last) != "[1,2;3,4]") THEN THROW "json read error"
+
 # find main.cpp in the console folder
 has_main = false
 func walker(node)
@@ -176,3 +176,44 @@ if expect != seq(0, 2*pi, 360/15+1) then throw "SEQ error"
 
 s="Hello\033There"
 if (27 != asc(mid(s, 6, 1))) then throw "err"
+
+rem --- append to the left side in place
+s = "a"
+for i = 1 to 3
+  s = s + "-" + i
+  s2 = s
+next
+if (s != "a-1-2-3" || s2 != s) then throw "append error"
+s = "12"
+s = s + 3 + "x"
+if (s != "15x") then throw "append numeric error"
+s = "ab"
+s = s + s
+if (s != "abab") then throw "append self error"
+s = ""
+for i = 1 to 1000
+  s = s + chr(65 + (i mod 26))
+next
+if (len(s) != 1000 || mid(s, 26, 2) != "AB") then throw "append grow error"
+' the terms are evaluated before a BYREF alias of the left side is appended to
+sub append_alias2(byref s, byref t)
+  s = s + t + t
+end
+sub append_alias1(byref s)
+  s = s + s_alias + s_alias
+end
+s = "x"
+append_alias2 s, s
+if (s != "xxx") then throw "append byref alias error"
+s_alias = "y"
+append_alias1 s_alias
+if (s_alias != "yyy") then throw "append global alias error"
+s = ""
+for i = 1 to 4
+  s = s + "z"
+next
+append_alias2 s, s
+if (s != "zzzzzzzzzzzz") then throw "append buffer alias error"
+s = "a"
+s = s + "1" + "2" + "3" + "4" + "5" + "6" + "7" + "8" + "9" + "a" + "b" + "c" + "d" + "e" + "f" + "g" + "h"
+if (s != "a123456789abcdefgh") then throw "append terms error"
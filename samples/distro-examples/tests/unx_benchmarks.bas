@@ -2,6 +2,9 @@
 '
 '
 
+' TICKS is in milliseconds
+tickspersec=1000
+
 st=ticks
 for i=1 to 1000000:next
 et=ticks
@@ -19,3 +22,27 @@ repeat:i=i+1:until i>=1000000
 et=ticks
 ? "REPEAT speed: "; ((et-st)/tickspersec); "sec "; round(1000000/((et-st)/tickspersec));" l/s"
 
+
+func byval_f(a, b)
+  byval_f = a
+end
+func byref_f(a, byref b)
+  byref_f = a
+end
+
+st=ticks
+for i=1 to 1000000:x=byval_f(i, 2):next
+et=ticks
+? "FUNC speed: "; ((et-st)/tickspersec); "sec "; round(1000000/((et-st)/tickspersec));" calls/s"
+
+st=ticks
+j=2
+for i=1 to 1000000:x=byref_f(i, j):next
+et=ticks
+? "FUNC BYREF speed: "; ((et-st)/tickspersec); "sec "; round(1000000/((et-st)/tickspersec));" calls/s"
+
+st=ticks
+dim a(1000000)
+for i=0 to 1000000:a(i)=[i, str(i)]:next
+et=ticks
+? "ARRAY speed: "; ((et-st)/tickspersec); "sec "; round(1000000/((et-st)/tickspersec));" l/s"
@@ -12,6 +12,7 @@
 #include "common/fmt.h"
 #include "common/keymap.h"
 #include "common/messages.h"
+#include "common/profile.h"
 
 #define STR_INIT_SIZE 256
 #define PKG_INIT_SIZE 5
@@ -20,8 +21,59 @@
  * LET v[(x)] = any
  * CONST v[(x)] = any
  */
+/**
+ * assignment to a packed array element. the array is checked again
+ * after evaluating the right hand side, which may have modified it
+ */
+static void cmd_let_packed(var_t *array, bcip_t idx, int is_opt) {
+  var_t v_right;
+  v_init(&v_right);
+  if (is_opt) {
+    // skip kwTYPE_CMPOPR + "=" and kwTYPE_VAR
+    code_skipopr();
+    code_skipnext();
+    v_set(&v_right, tvar[code_getaddr()]);
+  } else {
+    if (prog_source[prog_ip] == kwTYPE_CMPOPR &&
+        prog_source[prog_ip + 1] == '=') {
+      code_skipopr();
+    }
+    eval(&v_right);
+  }
+  if (prog_error) {
+    v_free(&v_right);
+  } else if (array->type != V_ARRAY || (int)idx >= v_asize(array)) {
+    err_arridx(idx, array->type == V_ARRAY ? v_asize(array) : 0);
+    v_free(&v_right);
+  } else if (v_packed(array) && v_packed_store(array, idx, &v_right)) {
+    v_free(&v_right);
+  } else {
+    // no free after v_move
+    v_move(v_elem(array, idx), &v_right);
+  }
+}
+
+/**
+ * returns the variable at IP when it is a plain variable, used to detect
+ * an array element or map field in its place
+ */
+static inline var_t *code_peekvar() {
+  return code_peek() == kwTYPE_VAR ? tvar[code_peek32(prog_ip + 1)] : NULL;
+}
+
 void cmd_let(int is_const) {
-  var_t *v_left = code_getvarptr();
+  var_t *v_left;
+  var_t *base = code_peekvar();
+  var_t *array = is_const ? NULL : code_getvar_packed();
+  if (array != NULL) {
+    bcip_t idx = code_get_packed_idx(array, &v_left);
+    if (idx != INVALID_ADDR) {
+      cmd_let_packed(array, idx, 0);
+      return;
+    }
+  } else {
+    v_left = code_getvarptr();
+  }
   if (!prog_error) {
     if (v_left->const_flag) {
       err_const();
@@ -30,9 +82,13 @@ void cmd_let(int is_const) {
           prog_source[prog_ip + 1] == '=') {
         code_skipopr();
       }
+      // v_left may be an element, don't share its array while it's held
+      int lock = (v_left != base);
       var_t v_right;
       v_init(&v_right);
+      v_share_lock += lock;
       eval(&v_right);
+      v_share_lock -= lock;
       v_move(v_left, &v_right);
       v_left->const_flag = is_const;
       // no free after v_move
@@ -41,7 +97,18 @@ void cmd_let(int is_const) {
 }
 
 void cmd_let_opt() {
-  var_t *v_left = code_getvarptr();
+  var_t *v_left;
+  var_t *base = code_peekvar();
+  var_t *array = code_getvar_packed();
+  if (array != NULL) {
+    bcip_t idx = code_get_packed_idx(array, &v_left);
+    if (idx != INVALID_ADDR) {
+      cmd_let_packed(array, idx, 1);
+      return;
+    }
+  } else {
+    v_left = code_getvarptr();
+  }
   if (!prog_error) {
     // skip kwTYPE_CMPOPR + "="
     code_skipopr();
@@ -49,11 +116,118 @@ void cmd_let_opt() {
     // skip kwTYPE_VAR
     code_skipnext();
 
-    v_set(v_left, tvar[code_getaddr()]);
+    var_t *v_right = tvar[code_getaddr()];
+    if (v_left == base) {
+      v_set(v_left, v_right);
+    } else {
+      // v_left may be an element of v_right, copy it before it's replaced
+      var_t v_copy;
+      v_init(&v_copy);
+      v_share_lock++;
+      v_set(&v_copy, v_right);
+      v_share_lock--;
+      v_move(v_left, &v_copy);
+      // no free after v_move
+    }
     v_left->const_flag = 0;
   }
 }
 
+/**
+ * a = a + expr [+ expr]..., compiled with the kwTYPE_EVPOP before each '+'
+ * replaced by kwTYPE_EOC. strings are appended in place without copying
+ * the left side
+ */
+void cmd_let_append() {
+  var_t *base = code_peekvar();
+  var_t *v_left = code_getvarptr();
+  if (!prog_error) {
+    if (v_left->const_flag) {
+      err_const();
+      return;
+    }
+    // skip kwTYPE_CMPOPR + "=" and kwTYPE_VAR
+    code_skipopr();
+    prog_ip += 1 + ADDRSZ;
+
+    // evaluate every term before the left side changes, a BYREF
+    // parameter in a term may refer to the same variable
+    var_t terms[LET_APPEND_TERMS];
+    int count = 0;
+    int lock = (v_left != base);
+    while ((code_peek() == kwTYPE_EVPUSH || code_peek() == kwTYPE_EVOPR) &&
+           !prog_error && count < LET_APPEND_TERMS) {
+      code_skipnext();
+      var_t *v_right = &terms[count++];
+      v_init(v_right);
+      v_share_lock += lock;
+      eval(v_right);
+      v_share_lock -= lock;
+      if (prog_error) {
+        break;
+      }
+      // skip kwTYPE_EOC and kwTYPE_ADDOPR + "+"
+      prog_ip += 3;
+    }
+    for (int i = 0; i < count; i++) {
+      var_t *v_right = &terms[i];
+      if (prog_error) {
+        v_free(v_right);
+      } else if (v_left->type == V_STR && v_right->type == V_STR) {
+        v_strappend(v_left, v_right->v.p.ptr, v_strlen(v_right));
+        v_free(v_right);
+      } else if (v_left->type == V_STR && (v_right->type == V_INT || v_right->type == V_NUM) &&
+                 !is_number(v_left->v.p.ptr)) {
+        char tmpsb[64];
+        if (v_right->type == V_INT) {
+          ltostr(v_right->v.i, tmpsb);
+        } else {
+          ftostr(v_right->v.n, tmpsb);
+        }
+        v_strcat(v_left, tmpsb);
+      } else {
+        eval_add(v_right, v_left);
+        v_move(v_left, v_right);
+        // no free after v_move
+      }
+    }
+  }
+}
+
+/**
+ * a = a + n or a = a - n, compiled as
+ * [var] [= var] [kwTYPE_EVOPR] [n] [kwTYPE_EVPOP] [kwTYPE_ADDOPR op].
+ * numbers are updated in place, otherwise this is a normal LET
+ */
+void cmd_let_inc() {
+  var_t *v_left = tvar[code_peek32(prog_ip + 1)];
+  if (!v_left->const_flag && (v_left->type == V_INT || v_left->type == V_NUM)) {
+    // skip [var] [= var] [kwTYPE_EVOPR]
+    prog_ip += (1 + ADDRSZ) * 2 + 3;
+    var_t v_right;
+    if (code_getnext() == kwTYPE_INT) {
+      v_right.type = V_INT;
+      v_right.v.i = code_getint();
+    } else {
+      v_right.type = V_NUM;
+      v_right.v.n = code_getreal();
+    }
+    // skip kwTYPE_EVPOP and kwTYPE_ADDOPR
+    prog_ip += 2;
+    byte op = code_getnext();
+    if (v_left->type == V_INT && v_right.type == V_INT) {
+      v_left->v.i = (op == '+') ? v_left->v.i + v_right.v.i : v_left->v.i - v_right.v.i;
+    } else {
+      var_num_t lf = v_left->type == V_INT ? v_left->v.i : v_left->v.n;
+      var_num_t rf = v_right.type == V_INT ? v_right.v.i : v_right.v.n;
+      v_left->type = V_NUM;
+      v_left->v.n = (op == '+') ? lf + rf : lf - rf;
+    }
+  } else {
+    cmd_let(0);
+  }
+}
+
 void cmd_packed_let() {
   if (code_peek() != kwTYPE_LEVEL_BEGIN) {
     err_missing_comma();
@@ -82,9 +256,11 @@ void cmd_packed_let() {
     // skip end separator
     code_skipnext();
 
+    // the vars may be elements, don't share their arrays while they're held
     var_t v_right_eval;
     var_t *v_right;
     v_init(&v_right_eval);
+    v_share_lock++;
     if (code_isvar()) {
       // avoid memory allocation
       v_right = code_getvarptr();
@@ -101,7 +277,8 @@ void cmd_packed_let() {
           v_set(vars[0], v_right);
         } else {
           for (int i = 0; i < count; i++) {
-            v_set(vars[i], v_elem(v_right, i));
+            var_t elem;
+            v_set(vars[i], v_elem_get(v_right, i, &elem));
           }
         }
       } else if (arrayCount > count) {
@@ -110,6 +287,7 @@ void cmd_packed_let() {
         rt_raise(ERR_PACK_TOO_FEW, arrayCount);
       }
     }
+    v_share_lock--;
     v_free(&v_right_eval);
     free(vars);
   }
@@ -212,17 +390,18 @@ void cmd_dim(int preserve) {
         size = size * (ABS(ubound[i] - lbound[i]) + 1);
       }
       if (!preserve || var_p->type != V_ARRAY) {
-        v_new_array(var_p, size);
+        v_new_packed_array(var_p, size);
       } else if (v_maxdim(var_p) != dimensions) {
         err_matdim();
       } else {
         // preserve previous array contents
         v_resize_array(var_p, size);
       }
-      v_maxdim(var_p) = dimensions;
+      var_dims_t *dims = v_array_dims(var_p);
+      dims->maxdim = dimensions;
       for (int i = 0; i < dimensions; i++) {
-        v_lbound(var_p, i) = lbound[i];
-        v_ubound(var_p, i) = ubound[i];
+        dims->lbound[i] = lbound[i];
+        dims->ubound[i] = ubound[i];
       }
     }
     free(lbound);
@@ -966,6 +1145,121 @@ void cmd_gosub() {
   code_jump_label(goto_label);
 }
 
+/**
+ * Returns whether the UDP at ip passes all of its parameters 'by value'
+ */
+static inline int cmd_udp_byval(bcip_t ip) {
+  if (prog_source[ip] != kwTYPE_PARAM) {
+    return 0;
+  }
+  int count = prog_source[ip + 1];
+  for (int i = 0; i < count; i++) {
+    if (prog_source[ip + 2 + i * (ADDRSZ + 1)] & 0x80) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Completes the call node once the arguments have been evaluated
+ */
+static void cmd_call_begin(stknode_t *vcall, bcip_t goto_addr, bcip_t rvid) {
+  vcall->x.vcall.ret_ip = prog_ip;   // where to go after exit (caller's next address)
+  vcall->x.vcall.rvid = rvid;        // return-variable ID
+
+  if (rvid != INVALID_ADDR) {
+    // if we call a function
+    vcall->x.vcall.retvar = tvar[rvid];  // store previous data of RVID
+    tvar[rvid] = v_new();    // create a temporary variable to store the function's result
+                             // value will be restored on udp-return
+  }
+  if (opt_profile) {
+    profile_enter(goto_addr);
+  }
+}
+
+/**
+ * Call a user-defined procedure or function having only 'by value' parameters
+ *
+ * What will happend to the stack
+ * [udp-call node]
+ * [parameters frame]
+ *
+ * the arguments are evaluated directly into the frame slots, then bound to
+ * the parameters. the UDP's kwTYPE_PARAM is skipped
+ *
+ * @return the address following the UDP's parameters
+ */
+static bcip_t cmd_push_frame(int cmd, bcip_t goto_addr, bcip_t rvid) {
+  bcip_t ip = goto_addr + 1;
+  int count = prog_source[ip++];
+  int pcount = 0;
+  frame_slot_t *slots = NULL;
+
+  stknode_t *vcall = code_push(cmd);
+  vcall->x.vcall.pcount = 0;          // the parameters are held in the frame
+  vcall->x.vcall.locks = 0;
+  vcall->x.vcall.rvid = INVALID_ADDR; // the result is created after the arguments
+  vcall->x.vcall.task_id = -1;
+  if (count && !prog_error) {
+    stknode_t *frame = code_push(kwTYPE_CRVAR);
+    slots = prog_error ? NULL : frame_alloc(frame, count);
+    for (int i = 0; slots != NULL && i < count; i++) {
+      slots[i].var.pooled = 0;
+      slots[i].vptr = NULL;
+      v_init(&slots[i].var);
+    }
+  }
+
+  byte ready = 0;
+  while (!ready && !prog_error) {
+    switch (code_peek()) {
+    case kwTYPE_EOC:       // end of an expression (parameter)
+      code_skipnext();
+      break;
+    case kwTYPE_SEP:       // separator (comma or semi-colon)
+      code_skipsep();
+      break;
+    case kwTYPE_LEVEL_END: // (right-parenthesis) which means: end of parameters
+      code_skipnext();
+      ready = 1;
+      break;
+    default:
+      if (pcount < count) {
+        var_t *var = &slots[pcount].var;
+        bcip_t ofs = prog_ip;
+        if (code_peek() == kwTYPE_VAR && code_isvar_inplace()) {
+          // a single variable
+          v_set(var, code_getvarptr());
+        } else {
+          prog_ip = ofs;
+          eval(var);
+        }
+      } else {
+        // too many, evaluated for the error message
+        var_t var;
+        v_init(&var);
+        eval(&var);
+        v_free(&var);
+      }
+      pcount++;
+    }
+  }
+
+  if (!prog_error && pcount != count) {
+    err_parm_num(pcount, count);
+  }
+  if (prog_error) {
+    return 0;
+  }
+  for (int i = 0; i < count; i++, ip += ADDRSZ + 1) {
+    frame_bind(&slots[i], code_peekaddr(ip + 1));
+  }
+  cmd_call_begin(vcall, goto_addr, rvid);
+  return ip;
+}
+
 /**
  * Call a user-defined procedure or function
  *
@@ -985,7 +1279,8 @@ void cmd_gosub() {
 bcip_t cmd_push_args(int cmd, bcip_t goto_addr, bcip_t rvid) {
   bcip_t ofs;
   bcip_t pcount = 0;
-  var_t *arg = NULL;
+  stknode_t *arg;
+  frame_slot_t *slot;
 
   if (code_peek() == kwTYPE_LEVEL_BEGIN) {
     // kwTYPE_LEVEL_BEGIN (which means left-parenthesis)
@@ -1005,6 +1300,10 @@ bcip_t cmd_push_args(int cmd, bcip_t goto_addr, bcip_t rvid) {
       rvid = var_ptr.v.ap.v;
     }
 
+    if (cmd_udp_byval(goto_addr)) {
+      return cmd_push_frame(cmd, goto_addr, rvid);
+    }
+
     byte ready = 0;
     do {
       byte code = code_peek();  // get next BC
@@ -1023,9 +1322,13 @@ bcip_t cmd_push_args(int cmd, bcip_t goto_addr, bcip_t rvid) {
       case kwTYPE_VAR:       // the parameter is a variable
         ofs = prog_ip;       // keep expression's IP
         if (code_isvar()) {  // this parameter is a single variable (it is not an expression)
+          var_t *base = code_peekvar();
           stknode_t *param = code_push(kwTYPE_VAR); // push parameter
           param->x.param.res = code_getvarptr(); // var_t pointer; the variable itself
           param->x.param.vcheck = 0x3; // parameter can be used 'by value' or 'by reference'
+          if (param->x.param.res != base) {
+            param->x.param.vcheck |= 0x4; // an array element or map field
+          }
           pcount++;
           break;             // we finished with this parameter
         }
@@ -1035,21 +1338,22 @@ bcip_t cmd_push_args(int cmd, bcip_t goto_addr, bcip_t rvid) {
         // no 'break' here
 
       default:
-        // default: the parameter is an expression
-        arg = v_new();       // create a new temporary variable; it is the
-                             // by-val value 'arg' will be freed at udp's return
-        eval(arg);           // execute the expression and store the result to 'arg'
-
-        if (!prog_error) {
-          stknode_t *param = code_push(kwTYPE_VAR); // push parameter
-          param->x.param.res = arg;  // var_t pointer; the variable itself
-          param->x.param.vcheck = 1; // parameter can be used only as 'by value'
-          pcount++;
-        } else {             // error; clean up and return
-          v_free(arg);
-          v_detach(arg);
+        // default: the parameter is an expression, it can be used only
+        // 'by value'. the result is stored directly in the frame slot
+        // which cmd_param() binds to the parameter
+        arg = code_push(kwTYPE_CRVAR);
+        slot = prog_error ? NULL : frame_alloc(arg, 1);
+        if (slot == NULL) {
           return 0;
         }
+        slot->var.pooled = 0;
+        slot->vptr = NULL;
+        v_init(&slot->var);
+        eval(&slot->var);    // the slot is freed with the node on error
+        if (prog_error) {
+          return 0;
+        }
+        pcount++;
       }
     } while (!ready);
   }
@@ -1057,16 +1361,9 @@ bcip_t cmd_push_args(int cmd, bcip_t goto_addr, bcip_t rvid) {
   // store call-info
   stknode_t *vcall = code_push(cmd); // store it to stack
   vcall->x.vcall.pcount = pcount;    // number parameter-nodes in the stack
-  vcall->x.vcall.ret_ip = prog_ip;   // where to go after exit (caller's next address)
-  vcall->x.vcall.rvid = rvid;        // return-variable ID
+  vcall->x.vcall.locks = 0;
   vcall->x.vcall.task_id = -1;
-
-  if (rvid != INVALID_ADDR) {
-    // if we call a function
-    vcall->x.vcall.retvar = tvar[rvid];  // store previous data of RVID
-    tvar[rvid] = v_new();    // create a temporary variable to store the function's result
-                             // value will be restored on udp-return
-  }
+  cmd_call_begin(vcall, goto_addr, rvid);
   return goto_addr;
 }
 
@@ -1111,11 +1408,15 @@ void cmd_call_unit_udp(int cmd, int udp_tid, bcip_t goto_addr, bcip_t rvid) {
         ofs = prog_ip;       // keep expression's IP
 
         if (code_isvar()) {  // this parameter is a single variable (not an expression)
+          var_t *base = code_peekvar();
           var_p_t var = code_getvarptr(); // var_t pointer; the variable itself
           activate_task(udp_tid);
           stknode_t *param = code_push(kwTYPE_VAR); // push parameter, on unit's task
           param->x.param.res = var;
           param->x.param.vcheck = 0x3; // parameter can be used 'by value' or 'by reference'
+          if (var != base) {
+            param->x.param.vcheck |= 0x4; // an array element or map field
+          }
           activate_task(my_tid);
           pcount++;
           break;             // we finished with this parameter
@@ -1160,6 +1461,7 @@ void cmd_call_unit_udp(int cmd, int udp_tid, bcip_t goto_addr, bcip_t rvid) {
 
   stknode_t *vcall = code_push(cmd); // store it to stack, on unit's task
   vcall->x.vcall.pcount = pcount;   // the number of parameter-nodes in the stack
+  vcall->x.vcall.locks = 0;
   vcall->x.vcall.ret_ip = prog_ip;   // where to go after exit (caller's next address)
   vcall->x.vcall.rvid = rvid;        // return-variable ID
   vcall->x.vcall.task_id = my_tid;
@@ -1179,18 +1481,20 @@ void cmd_call_unit_udp(int cmd, int udp_tid, bcip_t goto_addr, bcip_t rvid) {
 void cmd_crvar() {
   // number of variables to create
   int count = code_getnext();
+
+  // the variables are held in a single frame, the previous
+  // variables are restored at 'return'
+  stknode_t *node = code_push(kwTYPE_CRVAR);
+  if (prog_error) {
+    return;
+  }
+  frame_slot_t *slots = frame_alloc(node, count);
   for (int i = 0; i < count; i++) {
     // an ID on global-variable-table is used
     bcip_t vid = code_getaddr();
-
-    // store previous variable to stack
-    // we will restore it at 'return'
-    stknode_t *node = code_push(kwTYPE_CRVAR);
-    node->x.vdvar.vid = vid;
-    node->x.vdvar.vptr = tvar[vid];
-
-    // create a new variable with the same ID
-    tvar[vid] = v_new();
+    if (slots != NULL) {
+      frame_install(&slots[i], vid);
+    }
   }
 }
 
@@ -1200,7 +1504,8 @@ void cmd_crvar() {
  * this code will be called by udp/f to check parameter nodes
  * stored in stack by the cmd_udp (call to udp/f)
  *
- * 'by value' parameters are stored as local variables in the stack (kwTYPE_CRVAR)
+ * 'by value' parameters are stored as local variables in the stack (kwTYPE_CRVAR),
+ * expressions are passed in a kwTYPE_CRVAR frame slot which is bound in place
  * 'by reference' parameters are stored as local variables in the stack (kwTYPE_BYREF)
  */
 void cmd_param() {
@@ -1230,22 +1535,36 @@ void cmd_param() {
       var_t *param_var = node->x.param.res;
       int vcheck = node->x.param.vcheck;
 
-      if (node->type != kwTYPE_VAR) {
+      if (node->type == kwTYPE_CRVAR) {
+        // an expression, already evaluated into its frame slot by the CALL
+        if (vattr & 0x80) {
+          err_parm_byref(i);
+          break;
+        }
+        frame_bind(node->x.vframe.slots, vid);
+      } else if (node->type != kwTYPE_VAR) {
         err_stackmess();
         break;
-      }
-      else if ((vattr & 0x80) == 0) {
+      } else if ((vattr & 0x80) == 0) {
         // UDP requires a 'by value' parameter
-        node->type = kwTYPE_CRVAR;
-        node->x.vdvar.vid = vid;
-        node->x.vdvar.vptr = tvar[vid];
+        frame_slot_t *slot = frame_alloc(node, 1);
+        if (slot == NULL) {
+          if (vcheck == 1) {
+            v_free(param_var);
+            v_detach(param_var);
+          }
+          break;
+        }
 
         // assign
+        var_t *var = frame_install(slot, vid);
         if (vcheck == 1) {
-          // its already cloned by the CALL (expr)
-          tvar[vid] = param_var;
+          // its already evaluated by the CALL (expr), take over the value
+          *var = *param_var;
+          var->pooled = 0;
+          v_detach(param_var);
         } else {
-          tvar[vid] = v_clone(param_var);
+          v_set(var, param_var);
         }
       } else if (vcheck == 1) {
         // error - the parameter can be used only 'by value'
@@ -1257,6 +1576,11 @@ void cmd_param() {
         node->x.vdvar.vid = vid;
         node->x.vdvar.vptr = tvar[vid];
         tvar[vid] = param_var;
+        if (vcheck & 0x4) {
+          // don't share the element's array until the call returns
+          ncall->x.vcall.locks++;
+          v_share_lock++;
+        }
       }
     }
   }
@@ -1271,9 +1595,7 @@ void cmd_udpret() {
 
   // handle any values set with cmd_crvar()
   while (ncall.type == kwTYPE_CRVAR) {
-    v_free(tvar[ncall.x.vdvar.vid]);
-    v_detach(tvar[ncall.x.vdvar.vid]);
-    tvar[ncall.x.vdvar.vid] = ncall.x.vdvar.vptr;
+    frame_free(&ncall);
     code_pop(&ncall, 0);
   }
 
@@ -1284,6 +1606,11 @@ void cmd_udpret() {
     return;
   }
 
+  if (opt_profile) {
+    profile_leave();
+  }
+  v_share_lock -= ncall.x.vcall.locks;
+
   // handle parameters
   int i;
   for (i = ncall.x.vcall.pcount; i > 0 && !prog_error; i--) {
@@ -1292,11 +1619,8 @@ void cmd_udpret() {
 
     // local variable - cleanup
     if (node.type == kwTYPE_CRVAR) {
-      // free local variable data
-      v_free(tvar[node.x.vdvar.vid]);
-      v_detach(tvar[node.x.vdvar.vid]);
-      // restore ptr (replace to pre-call variable)
-      tvar[node.x.vdvar.vid] = node.x.vdvar.vptr;
+      // free local variable data and restore the pre-call variable
+      frame_free(&node);
     } else if (node.type == kwBYREF) {
       // variable 'by reference', restore ptr
       tvar[node.x.vdvar.vid] = node.x.vdvar.vptr;
@@ -1580,6 +1904,7 @@ void cmd_for_in(bcip_t true_ip, bcip_t false_ip, var_p_t var_p) {
     node.x.vfor.step_expr_ip = 0; // element-index
 
     var_p_t var_elem_ptr = 0;
+    var_t elem;
     switch (array_p->type) {
     case V_MAP:
       var_elem_ptr = map_elem_key(array_p, 0);
@@ -1587,7 +1912,7 @@ void cmd_for_in(bcip_t true_ip, bcip_t false_ip, var_p_t var_p) {
 
     case V_ARRAY:
       if (v_asize(array_p) > 0) {
-        var_elem_ptr = v_elem(array_p, 0);
+        var_elem_ptr = v_elem_get(array_p, 0, &elem);
       }
       break;
 
@@ -1610,6 +1935,36 @@ void cmd_for_in(bcip_t true_ip, bcip_t false_ip, var_p_t var_p) {
 //
 // FOR v1=exp1 TO exp2 [STEP exp3]
 //
+/*
+ * vfor.flags for integer FOR-TO loops
+ */
+#define FOR_INT       2
+#define FOR_INT_VAR   4
+
+/**
+ * returns the flags for an integer FOR-TO limit or step held between ip and end,
+ * either a constant (with an optional minus sign) or a simple variable
+ */
+static int for_int_expr(bcip_t ip, bcip_t end, var_int_t *value) {
+  int result = 0;
+  if (prog_source[ip] == kwTYPE_INT) {
+    if (end - ip == 1 + sizeof(var_int_t)) {
+      memcpy(value, prog_source + ip + 1, sizeof(var_int_t));
+      result = FOR_INT;
+    } else if (end - ip == 3 + sizeof(var_int_t) &&
+               prog_source[ip + 1 + sizeof(var_int_t)] == kwTYPE_UNROPR &&
+               prog_source[ip + 2 + sizeof(var_int_t)] == '-') {
+      memcpy(value, prog_source + ip + 1, sizeof(var_int_t));
+      *value = -*value;
+      result = FOR_INT;
+    }
+  } else if (prog_source[ip] == kwTYPE_VAR && end - ip == 1 + ADDRSZ) {
+    *value = code_peekaddr(ip + 1);
+    result = FOR_INT | FOR_INT_VAR;
+  }
+  return result;
+}
+
 void cmd_for_to(bcip_t true_ip, bcip_t false_ip, var_p_t var_p) {
   var_t varstep;
   var_t var;
@@ -1623,6 +1978,8 @@ void cmd_for_to(bcip_t true_ip, bcip_t false_ip, var_p_t var_p) {
   node.x.vfor.exit_ip = false_ip + ADDRSZ + ADDRSZ + 1;
   node.x.vfor.jump_ip = true_ip;
   node.x.vfor.var_ptr = var_p;
+  node.x.vfor.flags = 0;
+  node.x.vfor.step_int = 1;
 
   // get the first expression
   eval(&var);
@@ -1641,6 +1998,10 @@ void cmd_for_to(bcip_t true_ip, bcip_t false_ip, var_p_t var_p) {
       eval(&var);
 
       if (!prog_error && (var.type == V_NUM || var.type == V_INT)) {
+        if (var_p->type == V_INT && var.type == V_INT) {
+          node.x.vfor.flags = for_int_expr(node.x.vfor.to_expr_ip, prog_ip,
+                                           &node.x.vfor.to_int);
+        }
         //
         // step
         //
@@ -1653,6 +2014,11 @@ void cmd_for_to(bcip_t true_ip, bcip_t false_ip, var_p_t var_p) {
             if (!prog_error) {
               err_syntax(kwFOR, "%N");
             }
+          } else if (varstep.type != V_INT ||
+                     for_int_expr(node.x.vfor.step_expr_ip, prog_ip,
+                                  &node.x.vfor.step_int) != FOR_INT) {
+            // the step must be constant
+            node.x.vfor.flags = 0;
           }
         } else {
           node.x.vfor.step_expr_ip = INVALID_ADDR;
@@ -1790,6 +2156,31 @@ void cmd_next() {
   bcip_t next_ip = code_getaddr();
   code_skipaddr();
 
+  if (prog_stack_count) {
+    // integer FOR-TO, update the node in place
+    stknode_t *top = &prog_stack[prog_stack_count - 1];
+    if (top->type == kwFOR && (top->x.vfor.flags & FOR_INT)) {
+      var_t *var_p = top->x.vfor.var_ptr;
+      var_t *var_to = NULL;
+      if (top->x.vfor.flags & FOR_INT_VAR) {
+        var_to = tvar[top->x.vfor.to_int];
+      }
+      if (var_p->type == V_INT && (var_to == NULL || var_to->type == V_INT)) {
+        var_int_t to = var_to != NULL ? var_to->v.i : top->x.vfor.to_int;
+        var_int_t step = top->x.vfor.step_int;
+        var_p->v.i += step;
+        if (step < 0 ? var_p->v.i >= to : var_p->v.i <= to) {
+          code_jump(top->x.vfor.jump_ip);
+        } else {
+          stknode_t node;
+          code_pop(&node, kwFOR);
+          code_jump(next_ip);
+        }
+        return;
+      }
+    }
+  }
+
   stknode_t node;
   code_pop(&node, kwFOR);
 
@@ -1871,6 +2262,7 @@ void cmd_next() {
     //
     var_t *array_p = node.x.vfor.arr_ptr;
     var_t *var_elem_ptr = 0;
+    var_t elem;
 
     switch (array_p->type) {
     case V_MAP:
@@ -1882,7 +2274,7 @@ void cmd_next() {
       node.x.vfor.step_expr_ip++; // element-index
 
       if (v_asize(array_p) > (int) node.x.vfor.step_expr_ip) {
-        var_elem_ptr = v_elem(array_p, node.x.vfor.step_expr_ip);
+        var_elem_ptr = v_elem_get(array_p, node.x.vfor.step_expr_ip, &elem);
       } else {
         if (node.x.vfor.flags & 1) {
           // allocated in for
@@ -2301,7 +2693,8 @@ void cmd_wjoin() {
   str->v.p.ptr[0] = '\0';
 
   for (i = 0; i < v_asize(var_p); i++) {
-    var_t *elem_p = v_elem(var_p, i);
+    var_t elem;
+    var_t *elem_p = v_elem_get(var_p, i, &elem);
     var_t e_str;
 
     v_init(&e_str);
@@ -2320,7 +2713,7 @@ void cmd_wjoin() {
     strcat((char *)str->v.p.ptr, (char *)e_str.v.p.ptr);
     v_free(&e_str);
 
-    if (i != var_p->v.p.length - 1) {
+    if (i != v_asize(var_p) - 1) {
       strcat((char *)str->v.p.ptr, (char *)del.v.p.ptr);
       len += del_len;
     }
@@ -2470,36 +2863,208 @@ void cmd_timehms() {
 }
 
 /**
- * SORT array [USE ...]
+ * compares array elements, with an optional USE expression
  */
 int sb_qcmp(var_t *a, var_t *b, bcip_t use_ip) {
   if (use_ip == INVALID_ADDR) {
     return v_compare(a, b);
   } else {
-    var_t v1, v2;
+    var_t v;
     int r;
 
-    v_init(&v1);
-    v_init(&v2);
-
-    v_set(&v1, a);
-    v_set(&v2, b);
-    exec_usefunc2(&v1, &v2, use_ip);
-    r = v_igetval(&v1);
-    v_free(&v1);
+    v_init(&v);
+    exec_usefunc2_ref(&v, a, b, use_ip);
+    r = prog_error ? 0 : v_igetval(&v);
+    v_free(&v);
     return r;
   }
 }
 
-// using C's qsort()
-static bcip_t static_qsort_last_use_ip;
+typedef int (*sort_cmp_t)(var_t *a, var_t *b, bcip_t use_ip);
+
+static int sort_cmp_int(var_t *a, var_t *b, bcip_t use_ip) {
+  return a->v.i < b->v.i ? -1 : a->v.i > b->v.i ? 1 : 0;
+}
+
+static int sort_cmp_str(var_t *a, var_t *b, bcip_t use_ip) {
+  return strcmp(a->v.p.ptr, b->v.p.ptr);
+}
+
+/**
+ * LSD radix sort of the packed numeric elements, using keys which
+ * have the same order as the numbers when compared as unsigned
+ */
+static void sort_packed(var_t *var_p) {
+  const uint64_t sign = 1ULL << 63;
+  uint32_t size = v_asize(var_p);
+  v_array_unshare(var_p);
+  var_pack_t *data = v_pdata(var_p);
+  if (data == v_indexed_data) {
+    v_indexed_data = NULL;
+  }
+  int is_int = v_packed(var_p) == V_PACKED_INT;
+  uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * size * 2);
+  if (keys == NULL) {
+    err_memory();
+    return;
+  }
+  uint64_t *tmp = keys + size;
+  for (uint32_t i = 0; i < size; i++) {
+    if (is_int) {
+      keys[i] = (uint64_t)(int64_t)data[i].i ^ sign;
+    } else {
+      uint64_t bits;
+      memcpy(&bits, &data[i].n, sizeof(bits));
+      keys[i] = (bits & sign) ? ~bits : bits | sign;
+    }
+  }
+  for (int shift = 0; shift < 64; shift += 8) {
+    uint32_t count[256];
+    memset(count, 0, sizeof(count));
+    for (uint32_t i = 0; i < size; i++) {
+      count[(keys[i] >> shift) & 0xff]++;
+    }
+    if (count[(keys[0] >> shift) & 0xff] == size) {
+      // all the same digit
+      continue;
+    }
+    uint32_t pos = 0;
+    for (int d = 0; d < 256; d++) {
+      uint32_t n = count[d];
+      count[d] = pos;
+      pos += n;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+      tmp[count[(keys[i] >> shift) & 0xff]++] = keys[i];
+    }
+    uint64_t *swap = keys;
+    keys = tmp;
+    tmp = swap;
+  }
+  for (uint32_t i = 0; i < size; i++) {
+    if (is_int) {
+      data[i].i = (var_int_t)(int64_t)(keys[i] ^ sign);
+    } else {
+      uint64_t bits = (keys[i] & sign) ? keys[i] ^ sign : ~keys[i];
+      memcpy(&data[i].n, &bits, sizeof(bits));
+    }
+  }
+  free(keys < tmp ? keys : tmp);
+}
+
+/**
+ * stable merge sort of the element pointers, tmp holds at least n / 2 pointers
+ */
+static void sort_merge(var_t **list, var_t **tmp, uint32_t n, sort_cmp_t cmp, bcip_t use_ip) {
+  if (n <= 8) {
+    // insertion sort
+    for (uint32_t i = 1; i < n; i++) {
+      var_t *e = list[i];
+      uint32_t j = i;
+      while (j > 0 && cmp(list[j - 1], e, use_ip) > 0) {
+        list[j] = list[j - 1];
+        j--;
+      }
+      list[j] = e;
+    }
+  } else {
+    uint32_t mid = n / 2;
+    sort_merge(list, tmp, mid, cmp, use_ip);
+    sort_merge(list + mid, tmp, n - mid, cmp, use_ip);
+    if (cmp(list[mid - 1], list[mid], use_ip) > 0) {
+      // merge the left half from tmp with the right half in place
+      uint32_t i = 0, j = mid, k = 0;
+      memcpy(tmp, list, mid * sizeof(var_t *));
+      while (i < mid && j < n) {
+        if (cmp(tmp[i], list[j], use_ip) <= 0) {
+          list[k++] = tmp[i++];
+        } else {
+          list[k++] = list[j++];
+        }
+      }
+      while (i < mid) {
+        list[k++] = tmp[i++];
+      }
+    }
+  }
+}
+
+/**
+ * sorts the array elements. numeric and string arrays use a native comparison,
+ * the USE expression refers to the elements without copying them. the elements
+ * are held for the sort, so that a change made to the array by the expression
+ * copies them rather than freeing those X and Y refer to
+ */
+static void sort_array(var_t *var_p, bcip_t use_ip) {
+  uint32_t size = v_asize(var_p);
+  if (use_ip == INVALID_ADDR && v_packed(var_p)) {
+    sort_packed(var_p);
+    return;
+  }
+
+  var_t *data = v_array_data(var_p);
+  sort_cmp_t cmp = sb_qcmp;
+  if (use_ip == INVALID_ADDR) {
+    uint32_t ints = 0, strs = 0;
+    for (uint32_t i = 0; i < size; i++) {
+      if (data[i].type == V_INT) {
+        ints++;
+      } else if (data[i].type == V_STR) {
+        strs++;
+      }
+    }
+    if (ints == size) {
+      cmp = sort_cmp_int;
+    } else if (strs == size) {
+      cmp = sort_cmp_str;
+    }
+  }
 
-int qs_cmp(const void *a, const void *b) {
-  var_t *ea = (var_t *)a;
-  var_t *eb = (var_t *)b;
-  return sb_qcmp(ea, eb, static_qsort_last_use_ip);
+  var_t **list = (var_t **)malloc(sizeof(var_t *) * (size + size / 2));
+  var_t *sorted = (var_t *)malloc(sizeof(var_t) * size);
+  if (list == NULL || sorted == NULL) {
+    free(list);
+    free(sorted);
+    err_memory();
+    return;
+  }
+  for (uint32_t i = 0; i < size; i++) {
+    list[i] = &data[i];
+  }
+  var_t held;
+  v_init(&held);
+  if (use_ip == INVALID_ADDR) {
+    sort_merge(list, list + size, size, cmp, use_ip);
+  } else {
+    // share the elements with held even when called with the lock held,
+    // then lock so the USE expression can't share the array while it's
+    // being sorted
+    int lock = v_share_lock;
+    v_share_lock = 0;
+    v_set(&held, var_p);
+    v_share_lock = lock + 1;
+    sort_merge(list, list + size, size, cmp, use_ip);
+    v_share_lock = lock;
+  }
+  int changed = (v_data(var_p) != data);
+  v_free(&held);
+  if (changed) {
+    if (!prog_error) {
+      rt_raise(ERR_SORT_CHANGED);
+    }
+  } else {
+    for (uint32_t i = 0; i < size; i++) {
+      sorted[i] = *list[i];
+    }
+    memcpy(data, sorted, sizeof(var_t) * size);
+  }
+  free(sorted);
+  free(list);
 }
 
+/**
+ * SORT array [USE ...]
+ */
 void cmd_sort() {
   bcip_t use_ip, exit_ip;
   var_t *var_p;
@@ -2526,8 +3091,7 @@ void cmd_sort() {
   // sort
   if (!errf) {
     if (v_asize(var_p) > 1) {
-      static_qsort_last_use_ip = use_ip;
-      qsort(v_data(var_p), v_asize(var_p), sizeof(var_t), qs_cmp);
+      sort_array(var_p, use_ip);
     }
   }
   // NO RTE anymore... there is no meaning on this because of empty
@@ -2537,14 +3101,212 @@ void cmd_sort() {
   }
 }
 
+#define SEARCH_LINEAR 0
+#define SEARCH_SORTED 1
+#define SEARCH_HASH   2
+#define SEARCH_UNINDEXED (-2)
+
+/**
+ * hash index over a string or integer array, holding the index + 1 of
+ * the first element with each value. the index belongs to a single
+ * array and is rebuilt once v_indexed_data is cleared, when the elements
+ * may have been written, or when the array is resized. matches are always
+ * checked against the current element values
+ */
+typedef struct search_index_t {
+  var_t *array;
+  void *data;
+  uint32_t size;
+  uint32_t mask;
+  uint32_t *slots;
+  int type;
+} search_index_t;
+
+static search_index_t search_index;
+
+void search_index_free() {
+  if (search_index.data == v_indexed_data) {
+    v_indexed_data = NULL;
+  }
+  free(search_index.slots);
+  memset(&search_index, 0, sizeof(search_index));
+}
+
+static inline uint32_t search_hash_int(var_int_t value) {
+  uint64_t h = (uint64_t)value * 0x9E3779B97F4A7C15ULL;
+  return (uint32_t)(h >> 32);
+}
+
+static inline uint32_t search_hash_str(const char *value) {
+  uint32_t hash = 2166136261u;
+  while (*value) {
+    hash ^= (uint8_t)*value++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * returns V_INT or V_STR when every element has that type, otherwise -1
+ */
+static int search_array_type(var_t *var_p) {
+  uint32_t size = v_asize(var_p);
+  if (v_packed(var_p)) {
+    return v_packed(var_p) == V_PACKED_INT ? V_INT : -1;
+  }
+  int type = size ? v_data(var_p)[0].type : -1;
+  if (type != V_INT && type != V_STR) {
+    return -1;
+  }
+  for (uint32_t i = 1; i < size; i++) {
+    if (v_data(var_p)[i].type != type) {
+      return -1;
+    }
+  }
+  return type;
+}
+
+static inline var_int_t search_int_at(var_t *var_p, uint32_t i) {
+  return v_packed(var_p) ? v_pdata(var_p)[i].i : v_data(var_p)[i].v.i;
+}
+
+/**
+ * returns the first slot holding the value or the empty slot
+ */
+static uint32_t *search_index_slot(var_t *var_p, int type, var_int_t ivalue, const char *svalue) {
+  uint32_t index = (type == V_INT ? search_hash_int(ivalue) : search_hash_str(svalue)) & search_index.mask;
+  while (1) {
+    uint32_t *slot = &search_index.slots[index];
+    if (*slot == 0) {
+      return slot;
+    }
+    uint32_t i = *slot - 1;
+    if (type == V_INT ? (v_packed(var_p) == V_PACKED_INT || v_data(var_p)[i].type == V_INT) &&
+        search_int_at(var_p, i) == ivalue :
+        v_data(var_p)[i].type == V_STR && strcmp(v_data(var_p)[i].v.p.ptr, svalue) == 0) {
+      return slot;
+    }
+    index = (index + 1) & search_index.mask;
+  }
+}
+
+/**
+ * returns whether the index matches the array, (re)building it when required
+ */
+static int search_index_build(var_t *var_p) {
+  void *data = v_packed(var_p) ? (void *)v_pdata(var_p) : (void *)v_data(var_p);
+  if (search_index.array == var_p && search_index.data == data &&
+      data == v_indexed_data && search_index.size == v_asize(var_p)) {
+    return search_index.type != -1;
+  }
+  search_index_free();
+  v_indexed_data = data;
+  search_index.array = var_p;
+  search_index.data = data;
+  search_index.size = v_asize(var_p);
+  search_index.type = search_array_type(var_p);
+  if (search_index.type == -1) {
+    return 0;
+  }
+  uint32_t capacity = 16;
+  while (capacity < search_index.size * 2) {
+    capacity <<= 1;
+  }
+  search_index.slots = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+  if (search_index.slots == NULL) {
+    search_index_free();
+    err_memory();
+    return 0;
+  }
+  search_index.mask = capacity - 1;
+  for (uint32_t i = 0; i < search_index.size; i++) {
+    uint32_t *slot;
+    if (search_index.type == V_INT) {
+      slot = search_index_slot(var_p, V_INT, search_int_at(var_p, i), NULL);
+    } else {
+      slot = search_index_slot(var_p, V_STR, 0, v_data(var_p)[i].v.p.ptr);
+    }
+    if (*slot == 0) {
+      *slot = i + 1;
+    }
+  }
+  return 1;
+}
+
+/**
+ * hashed lookup, returns the element index, -1 when not found or
+ * SEARCH_UNINDEXED when the key or array cannot use the index
+ */
+static int search_hash(var_t *var_p, var_t *key) {
+  if (!search_index_build(var_p) || key->type != search_index.type) {
+    return SEARCH_UNINDEXED;
+  }
+  uint32_t *slot = search_index_slot(var_p, key->type, key->v.i,
+                                     key->type == V_STR ? key->v.p.ptr : NULL);
+  return *slot ? (int)*slot - 1 : -1;
+}
+
+/**
+ * returns the element for comparison, packed elements are copied to tmp
+ */
+static inline var_t *search_elem(var_t *var_p, uint32_t i, var_t *tmp) {
+  if (v_packed(var_p)) {
+    v_packed_get(var_p, i, tmp);
+    return tmp;
+  }
+  return &v_data(var_p)[i];
+}
+
+/**
+ * binary search of the sorted array, returns the first matching index or -1
+ */
+static int search_sorted(var_t *var_p, var_t *key, bcip_t use_ip) {
+  var_t tmp;
+  uint32_t lo = 0;
+  uint32_t hi = v_asize(var_p);
+  v_init(&tmp);
+  while (lo < hi && !prog_error) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (sb_qcmp(search_elem(var_p, mid, &tmp), key, use_ip) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  int result = -1;
+  if (lo < v_asize(var_p) && !prog_error &&
+      sb_qcmp(search_elem(var_p, lo, &tmp), key, use_ip) == 0) {
+    result = lo;
+  }
+  return result;
+}
+
+/**
+ * linear search, returns the first matching index or -1
+ */
+static int search_linear(var_t *var_p, var_t *key, bcip_t use_ip) {
+  var_t tmp;
+  v_init(&tmp);
+  for (uint32_t i = 0; i < v_asize(var_p) && !prog_error; i++) {
+    if (sb_qcmp(search_elem(var_p, i, &tmp), key, use_ip) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
 /**
- * SEARCH A(), key, BYREF ridx [USE ...]
+ * SEARCH A(), key, BYREF ridx [, mode] [USE ...]
+ *
+ * mode 0 scans the array, 1 uses a binary search of a sorted array,
+ * 2 uses a hash index over a string or integer array
  */
 void cmd_search() {
   bcip_t use_ip, exit_ip;
   var_t *var_p, *rv_p;
   var_t vkey;
   int errf = 0;
+  var_int_t mode = SEARCH_LINEAR;
 
   // parameters 1: the array
   if (code_isvar()) {
@@ -2582,6 +3344,18 @@ void cmd_search() {
     return;
   }
 
+  // parameters 4: the optional search mode
+  if (code_peek() == kwTYPE_SEP) {
+    par_getcomma();
+    if (!prog_error) {
+      mode = par_getint();
+    }
+    if (prog_error) {
+      v_free(&vkey);
+      return;
+    }
+  }
+
   // USE
   if (code_peek() == kwUSE) {
     code_skipnext();
@@ -2592,15 +3366,22 @@ void cmd_search() {
   }
   // search
   if (!errf) {
-    rv_p->v.i = v_lbound(var_p, 0) - 1;
-    for (int i = 0; i < v_asize(var_p); i++) {
-      var_t *elem_p = v_elem(var_p, i);
-      int bcmp = sb_qcmp(elem_p, &vkey, use_ip);
-      if (bcmp == 0) {
-        rv_p->v.i = i + v_lbound(var_p, 0);
-        break;
+    int index;
+    switch (mode) {
+    case SEARCH_SORTED:
+      index = search_sorted(var_p, &vkey, use_ip);
+      break;
+    case SEARCH_HASH:
+      index = use_ip == INVALID_ADDR ? search_hash(var_p, &vkey) : SEARCH_UNINDEXED;
+      if (index == SEARCH_UNINDEXED) {
+        index = search_linear(var_p, &vkey, use_ip);
       }
+      break;
+    default:
+      index = search_linear(var_p, &vkey, use_ip);
+      break;
     }
+    rv_p->v.i = index + v_lbound(var_p, 0);
   }
   // NO RTE anymore... there is no meaning on this because of empty
   // arrays/variables (example: TLOAD "data", V:SEARCH V...)
@@ -2843,18 +3624,20 @@ void cmd_end_try() {
 void cmd_call_vfunc() {
   var_t *map = NULL;
   var_t *v_func = code_getvarptr_map(&map);
-  if (v_func == NULL || (v_func->type != V_FUNC && v_func->type != V_PTR)) {
+  if (v_func == NULL || (v_func->type != V_FUNC && v_func->type != V_PTR) ||
+      (v_func->type == V_PTR && prog_source[v_func->v.ap.p] != kwTYPE_PARAM)) {
     rt_raise(ERR_NO_FUNC);
   } else if (v_func->type == V_PTR) {
     prog_ip = cmd_push_args(kwPROC, v_func->v.ap.p, v_func->v.ap.v);
-    if (code_peek() == kwTYPE_PARAM) {
+    if (!prog_error && code_peek() == kwTYPE_PARAM) {
+      // not already bound by cmd_push_args()
       code_skipnext();
       cmd_param();
+    }
+    if (!prog_error) {
       var_t *self = v_set_self(map);
       bc_loop(2);
       v_set_self(self);
-    } else {
-      rt_raise(ERR_NO_FUNC);
     }
   } else {
     if (code_peek() == kwTYPE_LEVEL_BEGIN) {
@@ -33,6 +33,8 @@ void cmd_param(void);
 int cmd_exit(void);
 void cmd_let(int);
 void cmd_let_opt();
+void cmd_let_append();
+void cmd_let_inc();
 void cmd_packed_let();
 void cmd_dim(int);
 void cmd_redim(void);
@@ -66,6 +68,7 @@ void cmd_data(void);
 void cmd_restore(void);
 void cmd_sort(void);
 void cmd_search(void);
+void search_index_free(void);
 void cmd_swap(void);
 void cmd_chain(void);
 void cmd_run(int);
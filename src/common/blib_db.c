@@ -15,6 +15,7 @@
 #include "common/blib.h"
 #include "common/messages.h"
 #include "common/fs_socket_client.h"
+#include "common/fs_stream.h"
 
 #include <dirent.h>
 
@@ -156,13 +157,15 @@ void write_encoded_var(int handle, var_t *var) {
     // write additional data about array
     dev_fwrite(handle, &v_maxdim(var), 1);
     for (int i = 0; i < v_maxdim(var); i++) {
-      dev_fwrite(handle, (byte *)&v_lbound(var, i), sizeof(int));
+      int lbound = v_lbound(var, i);
+      dev_fwrite(handle, (byte *)&lbound, sizeof(int));
       dev_fwrite(handle, (byte *)&v_ubound(var, i), sizeof(int));
     }
 
     // write elements
     for (int i = 0; i < v_asize(var); i++) {
-      var_t *elem = v_elem(var, i);
+      var_t tmp;
+      var_t *elem = v_elem_get(var, i, &tmp);
       write_encoded_var(handle, elem);
     }
     break;
@@ -194,6 +197,8 @@ int read_encoded_var(int handle, var_t *var) {
   case V_STR:
     var->type = V_STR;
     var->v.p.ptr = malloc(fv.size + 1);
+    var->v.p.length = fv.size + 1;
+    var->v.p.owner = 1;
     dev_fread(handle, (byte *)var->v.p.ptr, fv.size);
     var->v.p.ptr[fv.size] = '\0';
     break;
@@ -203,7 +208,9 @@ int read_encoded_var(int handle, var_t *var) {
     // read additional data about array
     dev_fread(handle, (byte *)&v_maxdim(var), 1);
     for (int i = 0; i < v_maxdim(var); i++) {
-      dev_fread(handle, (byte *)&v_lbound(var, i), sizeof(int));
+      int lbound;
+      dev_fread(handle, (byte *)&lbound, sizeof(int));
+      v_lbound(var, i) = lbound;
       dev_fread(handle, (byte *)&v_ubound(var, i), sizeof(int));
     }
 
@@ -350,37 +357,18 @@ void cmd_flineinput() {
             }
             var_t *var_p = code_getvarptr();
             if (!prog_error) {
+              uint32_t length;
+              char *line = dev_freadln(handle, &length);
               v_free(var_p);
-              int size = 256;
-              int index = 0;
-              byte ch;
-
-              var_p->type = V_STR;
-              var_p->v.p.ptr = malloc(size);
-
-              // READ IT
-              while (!dev_feof(handle)) {
-                dev_fread(handle, &ch, 1);
-                if (prog_error) {
-                  v_free(var_p);
-                  var_p->type = V_INT;
-                  var_p->v.i = -1;
-                  return;
-                } else if (ch == '\n') {
-                  break;
-                }
-                else if (ch != '\r') {
-                  // store char
-                  if (index == (size - 1)) {
-                    size += 256;
-                    var_p->v.p.ptr = realloc(var_p->v.p.ptr, size);
-                  }
-                  var_p->v.p.ptr[index] = ch;
-                  index++;
-                }
+              if (line == NULL) {
+                var_p->type = V_INT;
+                var_p->v.i = -1;
+              } else {
+                var_p->type = V_STR;
+                var_p->v.p.ptr = line;
+                var_p->v.p.length = length + 1;
+                var_p->v.p.owner = 1;
               }
-              var_p->v.p.ptr[index] = '\0';
-              var_p->v.p.length = index + 1;
             }
             else {
               rt_raise("FIO: FILE IS NOT OPENED");
@@ -398,8 +386,9 @@ void cmd_flineinput() {
       v_free(var_p);
       var_p->type = V_STR;
       var_p->v.p.ptr = calloc(SB_TEXTLINE_SIZE + 1, 1);
+      var_p->v.p.owner = 1;
       dev_gets((char *)var_p->v.p.ptr, SB_TEXTLINE_SIZE);
-      var_p->v.p.length = strlen(var_p->v.p.ptr);
+      var_p->v.p.length = strlen(var_p->v.p.ptr) + 1;
       dev_print("\n");
     }
   }
@@ -520,6 +509,48 @@ void cmd_mkdir() {
 #define CHK_ERR_CLEANUP(s) if (err_handle_error(s, &file_name)) return;
 #define CHK_ERR(s) if (err_handle_error(s, NULL)) return;
 
+/*
+ * builds the array of lines from the mapped file contents. the lines are
+ * counted first to size the array, then each is copied once without CR
+ */
+static void floadln_map(var_t *array_p, stream_map_t *map) {
+  const char *data = map->data;
+  const char *end = data + map->length;
+  uint32_t count = 0;
+
+  if (map->length) {
+    count = 1;
+    for (const char *p = data; (p = memchr(p, '\n', end - p)) != NULL; p++) {
+      count++;
+    }
+  }
+
+  v_toarray1(array_p, count);
+  for (uint32_t index = 0; index < count; index++) {
+    const char *lf = memchr(data, '\n', end - data);
+    size_t len = (lf != NULL ? lf : end) - data;
+    const char *cr = memchr(data, '\r', len);
+    size_t cr_count = 0;
+    for (const char *p = cr; p != NULL; p = memchr(p + 1, '\r', data + len - p - 1)) {
+      cr_count++;
+    }
+    var_t *var_p = v_elem(array_p, index);
+    v_init_str(var_p, len - cr_count);
+    if (cr == NULL) {
+      memcpy(var_p->v.p.ptr, data, len);
+    } else {
+      char *ptr = var_p->v.p.ptr;
+      for (size_t i = 0; i < len; i++) {
+        if (data[i] != '\r') {
+          *ptr++ = data[i];
+        }
+      }
+    }
+    var_p->v.p.ptr[len - cr_count] = '\0';
+    data += len + 1;
+  }
+}
+
 void cmd_floadln() {
   var_t file_name, *array_p = NULL, *var_p = NULL;
   int flags = DEV_FILE_INPUT;
@@ -579,7 +610,13 @@ void cmd_floadln() {
     CHK_ERR(FSERR_GENERIC);
   }
 
-  if (type == 0) {
+  dev_file_t *f = dev_getfileptr(handle);
+  stream_map_t map;
+  if (type == 0 && f != NULL && f->type == ft_stream && stream_map(f, &map)) {
+    // build array from the mapped file
+    floadln_map(array_p, &map);
+    stream_unmap(&map);
+  } else if (type == 0) {
     // build array
     int array_size = LDLN_INC;
     int index = 0;
@@ -593,7 +630,11 @@ void cmd_floadln() {
       // build var for line
       var_p = v_elem(array_p, index);
       int size = GROW_SIZE;
-      v_init_str(var_p, size);
+      var_p->type = V_STR;
+      var_p->v.p.ptr = malloc(size + 1);
+      var_p->v.p.owner = V_STR_OWNER;
+      var_p->v.p.ptr[0] = '\0';
+      var_p->v.p.length = 1;
       index++;
 
       // process the next line
@@ -654,6 +695,9 @@ void cmd_floadln() {
     } else {
       v_resize_array(array_p, 0); // v_free() is here
     }
+  } else if (type == 2) {
+    // parse JSON
+    map_parse_file(var_p, handle);
   } else {
     // type == 1, build string
     v_free(var_p);
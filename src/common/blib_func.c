@@ -1173,6 +1173,7 @@ void cmd_str1(long funcCode, var_t *arg, var_t *r) {
           var_t *elem_p = v_elem(r, i);
           elem_p->type = V_STR;
           elem_p->v.p.ptr = strdup(value != NULL ? value : "");
+          elem_p->v.p.owner = 1;
           elem_p->v.p.length = strlen(elem_p->v.p.ptr) + 1;
         }
       } else {
@@ -1715,7 +1716,7 @@ void cmd_strN(long funcCode, var_t *r) {
 
 void cmd_is_var_type(byte type, var_t *arg1, var_t *r) {
   var_t *var_p;
-  if (code_isvar()) {
+  if (code_isvar_inplace()) {
     var_p = code_getvarptr();
   } else {
     eval(arg1);
@@ -1787,7 +1788,7 @@ void cmd_intN(long funcCode, var_t *r) {
     //
     // bool <- ISNUMBER(v)
     //
-    if (code_isvar()) {
+    if (code_isvar_inplace()) {
       var_p = code_getvarptr();
     } else {
       eval(&arg1);
@@ -1824,7 +1825,7 @@ void cmd_intN(long funcCode, var_t *r) {
     //
     // int <- LEN(v)
     //
-    if (code_isvar()) {
+    if (code_isvar_inplace()) {
       var_p = code_getvarptr();
     } else {
       eval(&arg1);
@@ -1842,7 +1843,7 @@ void cmd_intN(long funcCode, var_t *r) {
     //
     // bool <- EMPTY(x)
     //
-    if (code_isvar()) {
+    if (code_isvar_inplace()) {
       var_p = code_getvarptr();
     } else {
       eval(&arg1);
@@ -2357,14 +2358,15 @@ void cmd_genfunc(long funcCode, var_t *r) {
   case kwPOINT: {
     int x = -1, y = -1;
     int y_set = 0;
-    if (code_isvar()) {
+    if (code_isvar_inplace()) {
       var_t *v = code_getvarptr();
       if (v->type == V_ARRAY) {
         if (v_asize(v) != 2) {
           err_argerr();
         } else {
-          x = v_getint(v_elem(v, 0));
-          y = v_getint(v_elem(v, 1));
+          var_t elem;
+          x = v_getint(v_elem_get(v, 0, &elem));
+          y = v_getint(v_elem_get(v, 1, &elem));
           y_set = 1;
         }
       } else {
@@ -2561,7 +2563,8 @@ void cmd_genfunc(long funcCode, var_t *r) {
           if (!prog_error && basevar_p->type == V_ARRAY) {
             count = v_asize(basevar_p);
             for (int i = 0; i < count; i++) {
-              var_t *elem_p = v_elem(basevar_p, i);
+              var_t elem;
+              var_t *elem_p = v_elem_get(basevar_p, i, &elem);
               if (!prog_error) {
                 if (first) {
                   dar_first(funcCode, r, elem_p);
@@ -2631,7 +2634,8 @@ void cmd_genfunc(long funcCode, var_t *r) {
           if (!prog_error && basevar_p->type == V_ARRAY) {
             count = v_asize(basevar_p);
             for (int i = 0; i < count; i++) {
-              var_t *elem_p = v_elem(basevar_p, i);
+              var_t elem;
+              var_t *elem_p = v_elem_get(basevar_p, i, &elem);
               if (!prog_error) {
                 if (tcount >= len) {
                   len += BUF_LEN;
@@ -162,52 +162,6 @@ void mat_gauss_jordan(var_num_t *a, var_num_t *b, int n, double toler) {
   free(ipiv);
 }
 
-/*
- */
-void mat_det2(var_num_t t, int m, int k, var_num_t *a, int *done, var_num_t *v, int n, double toler) {
-  if (k >= n) {
-    int s = -1;
-
-    if ((m % 2) == 0) {
-      s = 1;
-    }
-    *v += s * t;
-  } else {
-    if (ABS(t) > toler) {
-      int n2 = 0, j;
-
-      for (j = n - 1; j >= 0; j--) {
-        if (done[j]) {
-          n2++;
-        } else {
-          done[j] = 1;
-          mat_det2(t * a[k * n + j], m + n2, k + 1, a, done, v, n, toler);
-          done[j] = 0;
-        }
-      }
-    }
-  }
-}
-
-/*
- * Determinant of A
- */
-var_num_t mat_determ(var_num_t *a, int n, double toler) {
-  int *done;
-  int i;
-  var_num_t v;
-
-  done = malloc(n * sizeof(int));
-  for (i = 0; i < n; i++) {
-    done[i] = 0;
-  }
-  v = 0;
-  mat_det2(1, 0, 0, a, done, &v, n, toler);
-
-  free(done);
-  return v;
-}
-
 /*
  */
 var_num_t statmeandev(var_num_t *e, int count) {
@@ -40,6 +40,29 @@ var_num_t fround(var_num_t x, int dig);
  */
 void mat_gauss_jordan(var_num_t *a, var_num_t *b, int n, double toler);
 
+/**
+ * @ingroup math
+ *
+ * matrix multiplication, C = A * B
+ *
+ * @param a is the rows x inner matrix
+ * @param b is the inner x cols matrix
+ * @param c is the rows x cols result
+ */
+void mat_product(const var_num_t *a, const var_num_t *b, var_num_t *c, int rows, int inner, int cols);
+
+/**
+ * @ingroup math
+ *
+ * in-place LU decomposition with partial pivoting
+ *
+ * @param a is the matrix
+ * @param p receives the row permutation
+ * @param n is the number of rows/cols
+ * @return the number of row exchanges, or -1 when singular
+ */
+int mat_lu(var_num_t *a, int *p, int n);
+
 /**
  * @ingroup math
  *
@@ -50,9 +73,6 @@ void mat_gauss_jordan(var_num_t *a, var_num_t *b, int n, double toler);
  */
 void mat_inverse(var_num_t *a, int n);
 
-void mat_det2(var_num_t t, int m, int k, var_num_t *a, int *done, var_num_t *v, int n, double toler)
-   ;
-
 /**
  * @ingroup math
  *
@@ -61,7 +81,7 @@ void mat_det2(var_num_t t, int m, int k, var_num_t *a, int *done, var_num_t *v,
  * @param a is the matrix
  * @param n is the rows/cols of A
  * @param toler is the smallest acceptable number
- * @return the determinant of A
+ * @return the determinant of A, the contents of A are overwritten
  */
 var_num_t mat_determ(var_num_t *a, int n, double toler);
 
@@ -25,6 +25,8 @@
 #include "common/device.h"
 #include "common/pproc.h"
 #include "common/keymap.h"
+#include "common/profile.h"
+#include "lib/match.h"
 
 int brun_create_task(const char *filename, byte *preloaded_bc, int libf);
 int exec_close_task();
@@ -32,8 +34,11 @@ void sys_before_comp();
 
 static char fileName[OS_FILENAME_SIZE + 1];
 static stknode_t err_node;
+static uint32_t evt_next_check;
+uint32_t evt_instr_count;
 
 #define EVT_CHECK_EVERY 50
+#define FRAME_BLOCK_SIZE 256
 #define IF_ERR_BREAK if (prog_error) { \
   if (prog_error == errThrow)       \
       prog_error = errNone; else break;}
@@ -65,11 +70,7 @@ void free_node(stknode_t *node) {
   switch (node->type) {
   case kwTYPE_CRVAR:
     // free local variable data and retore ptr
-    if (node->x.vdvar.vptr != tvar[node->x.vdvar.vid]) {
-      v_free(tvar[node->x.vdvar.vid]);
-      v_detach(tvar[node->x.vdvar.vid]);
-      tvar[node->x.vdvar.vid] = node->x.vdvar.vptr;
-    }
+    frame_free(node);
     break;
 
   case kwBYREF:
@@ -90,6 +91,7 @@ void free_node(stknode_t *node) {
 
   case kwFUNC:
   case kwPROC:
+    v_share_lock -= node->x.vcall.locks;
     if (node->x.vcall.rvid != INVALID_ADDR) {
       v_detach(tvar[node->x.vcall.rvid]);
       tvar[node->x.vcall.rvid] = node->x.vcall.retvar;
@@ -123,6 +125,59 @@ void free_node(stknode_t *node) {
   }
 }
 
+/**
+ * Free the frame arena block and the blocks that follow it
+ */
+static void frame_free_blocks(frame_block_t *block) {
+  if (block->prev != NULL) {
+    block->prev->next = NULL;
+  }
+  while (block != NULL) {
+    frame_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+}
+
+/**
+ * Reserve the frame slots when they do not fit in the current block
+ */
+frame_slot_t *frame_grow(stknode_t *node, uint32_t count) {
+  node->type = kwTYPE_CRVAR;
+  node->x.vframe.block = NULL;
+  node->x.vframe.slots = NULL;
+  node->x.vframe.count = 0;
+
+  // continue in the next block, the blocks after the current one are unused
+  frame_block_t *block = prog_frame;
+  frame_block_t *next = block != NULL ? block->next : NULL;
+  if (next != NULL && next->size < count) {
+    frame_free_blocks(next);
+    next = NULL;
+  }
+  if (next == NULL) {
+    uint32_t size = count > FRAME_BLOCK_SIZE ? count : FRAME_BLOCK_SIZE;
+    next = (frame_block_t *)malloc(sizeof(frame_block_t) + sizeof(frame_slot_t) * size);
+    if (next == NULL) {
+      err_memory();
+      return NULL;
+    }
+    next->size = size;
+    next->prev = block;
+    next->next = NULL;
+    if (block != NULL) {
+      block->next = next;
+    }
+  }
+  next->count = count;
+  prog_frame = next;
+
+  node->x.vframe.block = next;
+  node->x.vframe.slots = next->slots;
+  node->x.vframe.count = count;
+  return next->slots;
+}
+
 /**
  * Returns and deletes the topmost node from stack (POP)
  */
@@ -694,6 +749,26 @@ static inline void bc_loop_end() {
   prog_error = errEnd;
 }
 
+/*
+ * ends a bc_loop() command. with USE_COMPUTED_GOTO the next command is
+ * dispatched from here while the event budget lasts, otherwise the head
+ * of the loop polls the events or handles the end of the program
+ */
+#if defined(USE_COMPUTED_GOTO)
+#define BC_NEXT                                                         \
+  if (!prog_error && prog_ip < prog_length &&                           \
+      ++evt_instr_count < EVT_CHECK_INSTR) {                            \
+    code = prog_source[prog_ip++];                                      \
+    if (opt_profile) {                                                  \
+      profile_commands++;                                               \
+    }                                                                   \
+    goto *bc_table[code];                                               \
+  }                                                                     \
+  continue
+#else
+#define BC_NEXT continue
+#endif
+
 /**
  * execute commands (loop)
  *
@@ -708,9 +783,47 @@ void bc_loop(int isf) {
   int proc_level = 0;
   byte code = 0;
 
-  // setup event checker time = 50ms
-  uint32_t now = dev_get_millisecond_count();
-  uint32_t next_check = now + EVT_CHECK_EVERY;
+#if defined(USE_COMPUTED_GOTO)
+  static const void *const bc_table[256] = {
+    [0 ... 255] = &&bc_switch,
+    DISPATCH_ENTRY(bc, kwLABEL), DISPATCH_ENTRY(bc, kwREM),
+    DISPATCH_ENTRY(bc, kwTYPE_EOC), DISPATCH_ENTRY(bc, kwTYPE_LINE),
+    DISPATCH_ENTRY(bc, kwLET), DISPATCH_ENTRY(bc, kwLET_OPT),
+    DISPATCH_ENTRY(bc, kwCONST), DISPATCH_ENTRY(bc, kwPACKED_LET),
+    DISPATCH_ENTRY(bc, kwLET_APPEND), DISPATCH_ENTRY(bc, kwLET_INC),
+    DISPATCH_ENTRY(bc, kwGOTO), DISPATCH_ENTRY(bc, kwGOSUB),
+    DISPATCH_ENTRY(bc, kwRETURN), DISPATCH_ENTRY(bc, kwONJMP),
+    DISPATCH_ENTRY(bc, kwPRINT), DISPATCH_ENTRY(bc, kwINPUT),
+    DISPATCH_ENTRY(bc, kwIF), DISPATCH_ENTRY(bc, kwELIF),
+    DISPATCH_ENTRY(bc, kwELSE), DISPATCH_ENTRY(bc, kwENDIF),
+    DISPATCH_ENTRY(bc, kwFOR), DISPATCH_ENTRY(bc, kwNEXT),
+    DISPATCH_ENTRY(bc, kwWHILE), DISPATCH_ENTRY(bc, kwWEND),
+    DISPATCH_ENTRY(bc, kwREPEAT), DISPATCH_ENTRY(bc, kwUNTIL),
+    DISPATCH_ENTRY(bc, kwSELECT), DISPATCH_ENTRY(bc, kwCASE),
+    DISPATCH_ENTRY(bc, kwCASE_ELSE), DISPATCH_ENTRY(bc, kwENDSELECT),
+    DISPATCH_ENTRY(bc, kwDIM), DISPATCH_ENTRY(bc, kwREDIM),
+    DISPATCH_ENTRY(bc, kwAPPEND), DISPATCH_ENTRY(bc, kwAPPEND_OPT),
+    DISPATCH_ENTRY(bc, kwINSERT), DISPATCH_ENTRY(bc, kwDELETE),
+    DISPATCH_ENTRY(bc, kwERASE), DISPATCH_ENTRY(bc, kwREAD),
+    DISPATCH_ENTRY(bc, kwDATA), DISPATCH_ENTRY(bc, kwRESTORE),
+    DISPATCH_ENTRY(bc, kwOPTION), DISPATCH_ENTRY(bc, kwTYPE_CALLEXTP),
+    DISPATCH_ENTRY(bc, kwTYPE_CALLP), DISPATCH_ENTRY(bc, kwTYPE_CALL_UDP),
+    DISPATCH_ENTRY(bc, kwTYPE_CALL_UDF), DISPATCH_ENTRY(bc, kwTYPE_RET),
+    DISPATCH_ENTRY(bc, kwTYPE_CRVAR), DISPATCH_ENTRY(bc, kwTYPE_PARAM),
+    DISPATCH_ENTRY(bc, kwEXIT), DISPATCH_ENTRY(bc, kwLINE),
+    DISPATCH_ENTRY(bc, kwCOLOR), DISPATCH_ENTRY(bc, kwOPEN),
+    DISPATCH_ENTRY(bc, kwCLOSE), DISPATCH_ENTRY(bc, kwFILEWRITE),
+    DISPATCH_ENTRY(bc, kwFILEREAD), DISPATCH_ENTRY(bc, kwLOGPRINT),
+    DISPATCH_ENTRY(bc, kwFILEPRINT), DISPATCH_ENTRY(bc, kwSPRINT),
+    DISPATCH_ENTRY(bc, kwLINEINPUT), DISPATCH_ENTRY(bc, kwSINPUT),
+    DISPATCH_ENTRY(bc, kwFILEINPUT), DISPATCH_ENTRY(bc, kwSEEK),
+    DISPATCH_ENTRY(bc, kwTRON), DISPATCH_ENTRY(bc, kwTROFF),
+    DISPATCH_ENTRY(bc, kwSTOP), DISPATCH_ENTRY(bc, kwEND),
+    DISPATCH_ENTRY(bc, kwCHAIN), DISPATCH_ENTRY(bc, kwRUN),
+    DISPATCH_ENTRY(bc, kwEXEC), DISPATCH_ENTRY(bc, kwTRY),
+    DISPATCH_ENTRY(bc, kwCATCH), DISPATCH_ENTRY(bc, kwENDTRY)
+  };
+#endif
 
   /**
    * For commands that change the IP use
@@ -724,63 +837,69 @@ void bc_loop(int isf) {
     proc_level++;
   }
   while (prog_ip < prog_length) {
-    switch (code) {
-    case kwLABEL:
-    case kwREM:
-    case kwTYPE_EOC:
-    case kwTYPE_LINE:
-      break;
-    default:
-      now = dev_get_millisecond_count();
-      break;
-    }
-
-    // check events every ~50ms
-    if (now >= next_check) {
-      next_check = now + EVT_CHECK_EVERY;
-
-      switch (dev_events(0)) {
-      case -1:
-        // break event
-        break;
-      case -2:
-        prog_error = errBreak;
-        inf_break(prog_line);
-        break;
-      default:
-        if (prog_timer) {
-          timer_run(now);
-        }
-      };
+    // check events every ~50ms, reading the clock once the commands cost EVT_CHECK_INSTR
+    if (++evt_instr_count >= EVT_CHECK_INSTR) {
+      uint32_t now = dev_get_millisecond_count();
+      evt_instr_count = 0;
+      if (now >= evt_next_check) {
+        evt_next_check = now + EVT_CHECK_EVERY;
+
+        switch (dev_events(0)) {
+        case -1:
+          // break event
+          break;
+        case -2:
+          prog_error = errBreak;
+          inf_break(prog_line);
+          break;
+        default:
+          if (prog_timer) {
+            timer_run(now);
+          }
+        };
+      }
     }
 
     // proceed to the next command
     if (!prog_error) {
       code = prog_source[prog_ip++];
+      if (opt_profile) {
+        profile_commands++;
+      }
+      DISPATCH(bc, code);
       switch (code) {
-      case kwLABEL:
-      case kwREM:
-      case kwTYPE_EOC:
-        continue;
-      case kwTYPE_LINE:
+      DISPATCH_CASE(bc, kwLABEL):
+      DISPATCH_CASE(bc, kwREM):
+      DISPATCH_CASE(bc, kwTYPE_EOC):
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwTYPE_LINE):
         prog_line = code_getaddr();
         if (opt_trace_on) {
           dev_trace_line(prog_line);
         }
-        continue;
-      case kwLET:
+        if (opt_profile) {
+          profile_line(prog_line);
+        }
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwLET):
         cmd_let(0);
         break;
-      case kwLET_OPT:
+      DISPATCH_CASE(bc, kwLET_OPT):
         cmd_let_opt();
         break;
-      case kwCONST:
+      DISPATCH_CASE(bc, kwCONST):
         cmd_let(1);
         break;
-      case kwPACKED_LET:
+      DISPATCH_CASE(bc, kwPACKED_LET):
         cmd_packed_let();
         break;
-      case kwGOTO:
+      DISPATCH_CASE(bc, kwLET_APPEND):
+        cmd_let_append();
+        break;
+      DISPATCH_CASE(bc, kwLET_INC):
+        cmd_let_inc();
+        break;
+      DISPATCH_CASE(bc, kwGOTO):
         next_ip = code_getaddr();
 
         // clear the stack (whatever you can)
@@ -792,129 +911,139 @@ void bc_loop(int isf) {
 
         // jump
         prog_ip = next_ip;
-        continue;
-      case kwGOSUB:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwGOSUB):
         cmd_gosub();
         IF_ERR_BREAK;
-        continue;
-      case kwRETURN:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwRETURN):
         cmd_return();
         IF_ERR_BREAK;
-        continue;
-      case kwONJMP:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwONJMP):
         cmd_on_go();
         IF_ERR_BREAK;
-        continue;
-      case kwPRINT:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwPRINT):
         cmd_print(PV_CONSOLE);
+        EVT_CHECK_SOON();
         break;
-      case kwINPUT:
+      DISPATCH_CASE(bc, kwINPUT):
         cmd_input(PV_CONSOLE);
+        EVT_CHECK_SOON();
         break;
-      case kwIF:
+      DISPATCH_CASE(bc, kwIF):
         cmd_if();
         IF_ERR_BREAK;
-        continue;
-      case kwELIF:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwELIF):
         cmd_elif();
         IF_ERR_BREAK;
-        continue;
-      case kwELSE:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwELSE):
         cmd_else();
         IF_ERR_BREAK;
-        continue;
-      case kwENDIF:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwENDIF):
         cmd_endif();
         IF_ERR_BREAK;
-        continue;
-      case kwFOR:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwFOR):
         cmd_for();
         IF_ERR_BREAK;
-        continue;
-      case kwNEXT:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwNEXT):
         cmd_next();
         IF_ERR_BREAK;
-        continue;
-      case kwWHILE:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwWHILE):
         cmd_while();
         IF_ERR_BREAK;
-        continue;
-      case kwWEND:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwWEND):
         cmd_wend();
         IF_ERR_BREAK;
-        continue;
-      case kwREPEAT:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwREPEAT):
         cmd_repeat();
         IF_ERR_BREAK;
-        continue;
-      case kwUNTIL:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwUNTIL):
         cmd_until();
         IF_ERR_BREAK;
-        continue;
-      case kwSELECT:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwSELECT):
         cmd_select();
         IF_ERR_BREAK;
-        continue;
-      case kwCASE:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwCASE):
         cmd_case();
         IF_ERR_BREAK;
-        continue;
-      case kwCASE_ELSE:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwCASE_ELSE):
         cmd_case_else();
         IF_ERR_BREAK;
-        continue;
-      case kwENDSELECT:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwENDSELECT):
         cmd_end_select();
         IF_ERR_BREAK;
-        continue;
-      case kwDIM:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwDIM):
         cmd_dim(0);
         break;
-      case kwREDIM:
+      DISPATCH_CASE(bc, kwREDIM):
         cmd_redim();
         break;
-      case kwAPPEND:
+      DISPATCH_CASE(bc, kwAPPEND):
         cmd_append();
         break;
-      case kwAPPEND_OPT:
+      DISPATCH_CASE(bc, kwAPPEND_OPT):
         cmd_append_opt();
         break;
-      case kwINSERT:
+      DISPATCH_CASE(bc, kwINSERT):
         cmd_lins();
         break;
-      case kwDELETE:
+      DISPATCH_CASE(bc, kwDELETE):
         cmd_ldel();
         break;
-      case kwERASE:
+      DISPATCH_CASE(bc, kwERASE):
         cmd_erase();
         break;
-      case kwREAD:
+      DISPATCH_CASE(bc, kwREAD):
         cmd_read();
         break;
-      case kwDATA:
+      DISPATCH_CASE(bc, kwDATA):
         cmd_data();
         break;
-      case kwRESTORE:
+      DISPATCH_CASE(bc, kwRESTORE):
         cmd_restore();
         break;
-      case kwOPTION:
+      DISPATCH_CASE(bc, kwOPTION):
         cmd_options();
         break;
-      case kwTYPE_CALLEXTP:
+      DISPATCH_CASE(bc, kwTYPE_CALLEXTP):
         bc_loop_call_extp();
+        EVT_CHECK_SOON();
         IF_ERR_BREAK;
-        continue;
-      case kwTYPE_CALLP:
-        bc_loop_call_proc();
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwTYPE_CALLP):
+        if (opt_profile) {
+          profile_enter_builtin(code_peekaddr(prog_ip));
+          bc_loop_call_proc();
+          profile_leave_builtin();
+        } else {
+          bc_loop_call_proc();
+        }
+        EVT_CHECK_SOON();
         break;
-      case kwTYPE_CALL_UDP:
+      DISPATCH_CASE(bc, kwTYPE_CALL_UDP):
         cmd_udp(kwPROC);
         if (isf) {
           proc_level++;
         }
         IF_ERR_BREAK;
-        continue;
-      case kwTYPE_CALL_UDF:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwTYPE_CALL_UDF):
         if (isf) {
           cmd_udp(kwFUNC);
           proc_level++;
@@ -922,8 +1051,8 @@ void bc_loop(int isf) {
           err_syntax(kwTYPE_CALL_UDF, "%G");
         }
         IF_ERR_BREAK;
-        continue;
-      case kwTYPE_RET:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwTYPE_RET):
         cmd_udpret();
         if (isf) {
           proc_level--;
@@ -932,14 +1061,14 @@ void bc_loop(int isf) {
           }
         }
         IF_ERR_BREAK;
-        continue;
-      case kwTYPE_CRVAR:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwTYPE_CRVAR):
         cmd_crvar();
         break;
-      case kwTYPE_PARAM:
+      DISPATCH_CASE(bc, kwTYPE_PARAM):
         cmd_param();
         break;
-      case kwEXIT:
+      DISPATCH_CASE(bc, kwEXIT):
         pops = cmd_exit();
         if (isf && pops) {
           proc_level--;
@@ -948,76 +1077,85 @@ void bc_loop(int isf) {
           }
         }
         IF_ERR_BREAK;
-        continue;
-      case kwLINE:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwLINE):
         cmd_line();
         break;
-      case kwCOLOR:
+      DISPATCH_CASE(bc, kwCOLOR):
         cmd_color();
         break;
-      case kwOPEN:
+      DISPATCH_CASE(bc, kwOPEN):
         cmd_fopen();
+        EVT_CHECK_SOON();
         break;
-      case kwCLOSE:
+      DISPATCH_CASE(bc, kwCLOSE):
         cmd_fclose();
+        EVT_CHECK_SOON();
         break;
-      case kwFILEWRITE:
+      DISPATCH_CASE(bc, kwFILEWRITE):
         cmd_fwrite();
+        EVT_CHECK_SOON();
         break;
-      case kwFILEREAD:
+      DISPATCH_CASE(bc, kwFILEREAD):
         cmd_fread();
+        EVT_CHECK_SOON();
         break;
-      case kwLOGPRINT:
+      DISPATCH_CASE(bc, kwLOGPRINT):
         cmd_print(PV_LOG);
+        EVT_CHECK_SOON();
         break;
-      case kwFILEPRINT:
+      DISPATCH_CASE(bc, kwFILEPRINT):
         cmd_print(PV_FILE);
+        EVT_CHECK_SOON();
         break;
-      case kwSPRINT:
+      DISPATCH_CASE(bc, kwSPRINT):
         cmd_print(PV_STRING);
         break;
-      case kwLINEINPUT:
+      DISPATCH_CASE(bc, kwLINEINPUT):
         cmd_flineinput();
+        EVT_CHECK_SOON();
         break;
-      case kwSINPUT:
+      DISPATCH_CASE(bc, kwSINPUT):
         cmd_input(PV_STRING);
         break;
-      case kwFILEINPUT:
+      DISPATCH_CASE(bc, kwFILEINPUT):
         cmd_input(PV_FILE);
+        EVT_CHECK_SOON();
         break;
-      case kwSEEK:
+      DISPATCH_CASE(bc, kwSEEK):
         cmd_fseek();
+        EVT_CHECK_SOON();
         break;
-      case kwTRON:
+      DISPATCH_CASE(bc, kwTRON):
         opt_trace_on = 1;
-        continue;
-      case kwTROFF:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwTROFF):
         opt_trace_on = 0;
-        continue;
-      case kwSTOP:
-      case kwEND:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwSTOP):
+      DISPATCH_CASE(bc, kwEND):
         bc_loop_end();
         break;
-      case kwCHAIN:
+      DISPATCH_CASE(bc, kwCHAIN):
         cmd_chain();
         break;
-      case kwRUN:
+      DISPATCH_CASE(bc, kwRUN):
         cmd_run(1);
         break;
-      case kwEXEC:
+      DISPATCH_CASE(bc, kwEXEC):
         cmd_run(0);
         break;
-      case kwTRY:
+      DISPATCH_CASE(bc, kwTRY):
         cmd_try();
         IF_ERR_BREAK;
-        continue;
-      case kwCATCH:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwCATCH):
         cmd_catch();
         IF_ERR_BREAK;
-        continue;
-      case kwENDTRY:
+        BC_NEXT;
+      DISPATCH_CASE(bc, kwENDTRY):
         cmd_end_try();
-        continue;
+        BC_NEXT;
       default:
         log_printf("OUT OF ADDRESS SPACE\n");
         for (i = 0; keyword_table[i].name[0] != '\0'; i++) {
@@ -1039,6 +1177,9 @@ void bc_loop(int isf) {
         if (opt_trace_on) {
           dev_trace_line(prog_line);
         }
+        if (opt_profile) {
+          profile_line(prog_line);
+        }
       } else if (code != kwTYPE_EOC) {
         if (!opt_quiet) {
           hex_dump(prog_source, prog_length);
@@ -1053,6 +1194,7 @@ void bc_loop(int isf) {
     }
     // quit on error
     IF_ERR_BREAK;
+    BC_NEXT;
   }
 }
 
@@ -1231,6 +1373,7 @@ int brun_create_task(const char *filename, byte *preloaded_bc, int libf) {
   prog_stack_alloc = SB_EXEC_STACK_SIZE;
   prog_stack = malloc(sizeof(stknode_t) * prog_stack_alloc);
   prog_stack_count = 0;
+  prog_frame = NULL;
   prog_timer = NULL;
 
   // create eval's stack
@@ -1325,6 +1468,13 @@ int exec_close_task() {
       code_pop_and_free();
     }
     free(prog_stack);
+    if (prog_frame != NULL) {
+      while (prog_frame->prev != NULL) {
+        prog_frame = prog_frame->prev;
+      }
+      frame_free_blocks(prog_frame);
+      prog_frame = NULL;
+    }
     // clean up - variables
     for (int i = 0; i < (int) prog_varcount; i++) {
       // do not free imported variables
@@ -1368,6 +1518,12 @@ int exec_close_task() {
     // cleanup the keyboard map
     keymap_free();
 
+    // cleanup the SEARCH index
+    search_index_free();
+
+    // cleanup the compiled regular expressions
+    reg_match_free();
+
     // cleanup timers
     timer_free(prog_timer);
     prog_timer = NULL;
@@ -1574,7 +1730,7 @@ int sbasic_exec_prepare(const char *filename) {
   v_init_pool();
 
   // load source
-  if (opt_nosave) {
+  if (opt_nosave || ctask->bytecode != NULL) {
     taskId = brun_create_task(filename, ctask->bytecode, 0);
   } else {
     taskId = brun_create_task(filename, 0, 0);
@@ -1624,13 +1780,9 @@ void sbasic_set_bas_dir(const char *bas_file) {
 }
 
 /**
- * this is the main 'execute' routine; its work depended on opt_xxx flags
- * use it instead of sbasic_main if managers are already initialized
- *
- * @param file the source file
- * @return true on success
+ * runs a copy of already compiled bytecode, or otherwise compiles the file
  */
-int sbasic_exec(const char *file) {
+static int sbasic_exec_bc(const char *file, const byte *bytecode) {
   int success = 0;
   int exec_rq = 1;
 
@@ -1644,7 +1796,16 @@ int sbasic_exec(const char *file) {
   strlcpy(gsb_last_file, file, sizeof(gsb_last_file));
   strcpy(gsb_last_errmsg, "");
   sbasic_set_bas_dir(file);
-  success = sbasic_compile(file);
+  if (bytecode != NULL) {
+    bc_head_t hdr;
+    memcpy(&hdr, bytecode, sizeof(bc_head_t));
+    ctask->bytecode = malloc(hdr.size);
+    memcpy(ctask->bytecode, bytecode, hdr.size);
+    ctask->bc_type = 1;
+    success = 1;
+  } else {
+    success = sbasic_compile(file);
+  }
 
   if (ctask->bc_type == 2) {
     // cannot run a unit
@@ -1661,9 +1822,16 @@ int sbasic_exec(const char *file) {
 
     dev_init(opt_graphics, 0);  // initialize output device for graphics
     srand(clock());             // randomize
+    v_share_lock = 0;           // arrays are shared on assignment
 
     // run
+    if (opt_profile) {
+      profile_begin(exec_tid);
+    }
     sbasic_recursive_exec(exec_tid);
+    if (opt_profile) {
+      profile_end();
+    }
 
     // normal exit
     if (!opt_quiet) {
@@ -1671,6 +1839,7 @@ int sbasic_exec(const char *file) {
     }
 
     exec_close(exec_tid);       // clean up executor's garbages
+    v_free_pool();              // release the variables
     dev_restore();              // restore device
   }
 
@@ -1678,6 +1847,84 @@ int sbasic_exec(const char *file) {
   return !success ? 0 : !gsb_last_error;
 }
 
+/**
+ * this is the main 'execute' routine; its work depended on opt_xxx flags
+ * use it instead of sbasic_main if managers are already initialized
+ *
+ * @param file the source file
+ * @return true on success
+ */
+int sbasic_exec(const char *file) {
+  return sbasic_exec_bc(file, NULL);
+}
+
+/**
+ * compiles the file into bytecode for use with sbasic_main_bc()
+ *
+ * @param file the source file
+ * @param depends set to non-zero when the program was compiled with INCLUDE
+ *        or IMPORT files, which may change independently of the file
+ * @return the bytecode, or NULL on error. the caller owns the result
+ */
+byte *sbasic_main_compile(const char *file, int *depends) {
+  byte *result = NULL;
+  *depends = 0;
+
+  // initialize managers
+  init_tasks();
+  unit_mgr_init();
+  slib_init();
+
+  if (!prog_error) {
+    int nosave = opt_nosave;
+    opt_nosave = 1;
+    sbasic_set_bas_dir(file);
+    if (comp_compile(file) && ctask->bc_type == 1) {
+      result = ctask->bytecode;
+      ctask->bytecode = NULL;
+      *depends = ctask->bc_depends;
+    }
+    opt_nosave = nosave;
+  }
+
+  // clean up managers
+  slib_close();
+  unit_mgr_close();
+  destroy_tasks();
+
+  return result;
+}
+
+/**
+ * variant of sbasic_main() which runs bytecode from sbasic_main_compile()
+ * instead of compiling the file. the bytecode is not modified
+ *
+ * @param file the source file
+ * @param bytecode the compiled file
+ * @return true on success
+ */
+int sbasic_main_bc(const char *file, const byte *bytecode) {
+  int success;
+
+  // initialize managers
+  init_tasks();
+  unit_mgr_init();
+  slib_init();
+
+  if (prog_error) {
+    success = 0;
+  } else {
+    success = sbasic_exec_bc(file, bytecode);
+  }
+
+  // clean up managers
+  slib_close();
+  unit_mgr_close();
+  destroy_tasks();
+
+  return success;
+}
+
 /**
  * this is the main routine; its work depended on opt_xxx flags
  *
@@ -216,6 +216,117 @@ void cev_prim() {
   };
 }
 
+/*
+ * returns whether the output between ip and end holds a single
+ * integer or real constant, and stores the value in v
+ */
+static int cev_get_const(bcip_t ip, bcip_t end, var_t *v) {
+  int result = 0;
+  if (bc_out->ptr[ip] == kwTYPE_INT && end - ip == 1 + OS_INTSZ) {
+    v->type = V_INT;
+    memcpy(&v->v.i, bc_out->ptr + ip + 1, OS_INTSZ);
+    result = 1;
+  } else if (bc_out->ptr[ip] == kwTYPE_NUM && end - ip == 1 + OS_REALSZ) {
+    v->type = V_NUM;
+    memcpy(&v->v.n, bc_out->ptr + ip + 1, OS_REALSZ);
+    result = 1;
+  }
+  return result;
+}
+
+static void cev_add_const(var_t *v) {
+  if (v->type == V_INT) {
+    bc_add_cint(bc_out, v->v.i);
+  } else {
+    bc_add_creal(bc_out, v->v.n);
+  }
+}
+
+/*
+ * returns whether the output from ip to the end is a single constant or
+ * variable, which eval() reads without using the stack
+ */
+static int cev_is_operand(bcip_t ip) {
+  uint32_t len;
+  bcip_t size = bc_out->count - ip;
+  switch (bc_out->ptr[ip]) {
+  case kwTYPE_INT:
+    return size == 1 + OS_INTSZ;
+  case kwTYPE_NUM:
+    return size == 1 + OS_REALSZ;
+  case kwTYPE_VAR:
+    return size == 1 + ADDRSZ;
+  case kwTYPE_STR:
+    memcpy(&len, bc_out->ptr + ip + 1, OS_STRLEN);
+    return size == 1 + OS_STRLEN + len;
+  default:
+    return 0;
+  }
+}
+
+/*
+ * calculates LEFT op R for two constants with the same result as eval()
+ */
+static int cev_fold(var_t *left, var_t *r, byte type, byte op) {
+  var_num_t lf = left->type == V_INT ? left->v.i : left->v.n;
+  var_num_t rf = r->type == V_INT ? r->v.i : r->v.n;
+  int result = 1;
+
+  switch (type) {
+  case kwTYPE_ADDOPR:
+    if (left->type == V_INT && r->type == V_INT) {
+      r->v.i = (op == '+') ? left->v.i + r->v.i : left->v.i - r->v.i;
+    } else {
+      r->type = V_NUM;
+      r->v.n = (op == '+') ? lf + rf : lf - rf;
+    }
+    break;
+  case kwTYPE_MULOPR:
+    if (op == '*') {
+      r->type = V_NUM;
+      r->v.n = lf * rf;
+    } else if (op == '/' && rf != 0) {
+      r->type = V_NUM;
+      r->v.n = lf / rf;
+    } else {
+      // leave division by zero and the integer operators to eval()
+      result = 0;
+    }
+    break;
+  case kwTYPE_POWOPR:
+    r->type = V_NUM;
+    r->v.n = pow(lf, rf);
+    break;
+  default:
+    result = 0;
+    break;
+  }
+  return result;
+}
+
+/*
+ * R = LEFT op R, where the output for LEFT starts at left and the
+ * output for R starts at right, after the kwTYPE_EVPUSH
+ */
+static void cev_add_opr(bcip_t left, bcip_t right, byte type, byte op) {
+  var_t v_left, v_right;
+  if (type != kwTYPE_CMPOPR &&
+      cev_get_const(left, right - 1, &v_left) &&
+      cev_get_const(right, bc_out->count, &v_right) &&
+      cev_fold(&v_left, &v_right, type, op)) {
+    // replace both constants with the result
+    bc_out->count = left;
+    cev_add_const(&v_right);
+  } else {
+    if (cev_is_operand(right)) {
+      // R is read in place and LEFT taken from R without the stack
+      bc_out->ptr[right - 1] = kwTYPE_EVOPR;
+    }
+    cev_add1(kwTYPE_EVPOP);     // POP LEFT
+    cev_add2(type, op);         // R = LEFT op R
+  }
+}
+
 /*
  * parenthesis
  */
@@ -245,10 +356,25 @@ void cev_unary() {
   } else {
     op = 0;
   }
+  bcip_t start = bc_out->count;
   cev_parenth();        // R = cev_parenth
   if (op) {
-    cev_add1(kwTYPE_UNROPR);
-    cev_add1(op);       // R = op R
+    var_t v;
+    if ((op == '-' || op == '+') && cev_get_const(start, bc_out->count, &v)) {
+      // fold -constant
+      if (op == '-') {
+        if (v.type == V_INT) {
+          v.v.i = -v.v.i;
+        } else {
+          v.v.n = -v.v.n;
+        }
+      }
+      bc_out->count = start;
+      cev_add_const(&v);
+    } else {
+      cev_add1(kwTYPE_UNROPR);
+      cev_add1(op);     // R = op R
+    }
   }
 }
 
@@ -256,6 +382,7 @@ void cev_unary() {
  * pow
  */
 void cev_pow() {
+  bcip_t left = bc_out->count;
   cev_unary();                  // R = cev_unary
 
   IF_ERR_RTN;
@@ -263,10 +390,10 @@ void cev_pow() {
     IP += 2;
 
     cev_add1(kwTYPE_EVPUSH);    // PUSH R
+    bcip_t right = bc_out->count;
     cev_unary();                // R = cev_unary
     IF_ERR_RTN;
-    cev_add1(kwTYPE_EVPOP);     // POP LEFT
-    cev_add2(kwTYPE_POWOPR, '^'); // R = LEFT op R
+    cev_add_opr(left, right, kwTYPE_POWOPR, '^');
   }
 }
 
@@ -274,6 +401,7 @@ void cev_pow() {
  * mul | div | mod
  */
 void cev_mul() {
+  bcip_t left = bc_out->count;
   cev_pow();                    // R = cev_pow()
 
   IF_ERR_RTN;
@@ -283,11 +411,11 @@ void cev_mul() {
     op = CODE(++IP);
     IP++;
     cev_add1(kwTYPE_EVPUSH);    // PUSH R
+    bcip_t right = bc_out->count;
 
     cev_pow();
     IF_ERR_RTN;
-    cev_add1(kwTYPE_EVPOP);      // POP LEFT
-    cev_add2(kwTYPE_MULOPR, op); // R = LEFT op R
+    cev_add_opr(left, right, kwTYPE_MULOPR, op);
   }
 }
 
@@ -295,6 +423,7 @@ void cev_mul() {
  * add | sub
  */
 void cev_add() {
+  bcip_t left = bc_out->count;
   cev_mul();                    // R = cev_mul()
 
   IF_ERR_RTN;
@@ -305,12 +434,11 @@ void cev_add() {
     op = CODE(IP);
     IP++;
     cev_add1(kwTYPE_EVPUSH);    // PUSH R
+    bcip_t right = bc_out->count;
 
     cev_mul();                  // R = cev_mul
     IF_ERR_RTN;
-
-    cev_add1(kwTYPE_EVPOP);    // POP LEFT
-    cev_add2(kwTYPE_ADDOPR, op); // R = LEFT op R
+    cev_add_opr(left, right, kwTYPE_ADDOPR, op);
   }
 }
 
@@ -318,6 +446,7 @@ void cev_add() {
  * compare
  */
 void cev_cmp() {
+  bcip_t left = bc_out->count;
   cev_add();                    // R = cev_add()
 
   IF_ERR_RTN;
@@ -328,10 +457,10 @@ void cev_cmp() {
     op = CODE(IP);
     IP++;
     cev_add1(kwTYPE_EVPUSH);    // PUSH R
+    bcip_t right = bc_out->count;
     cev_add();                  // R = cev_add()
     IF_ERR_RTN;
-    cev_add1(kwTYPE_EVPOP);         // POP LEFT
-    cev_add2(kwTYPE_CMPOPR, op);    // R = LEFT op R
+    cev_add_opr(left, right, kwTYPE_CMPOPR, op);
   }
 }
 
@@ -808,8 +808,17 @@ typedef struct {
   int handle;         /**< the file handle */
   int last_error;     /**< the last error-code */
   int open_flags;     /**< the open()'s flags */
+
+  byte *buffer;       /**< stream read or write buffer, NULL when unbuffered */
+  uint32_t buf_size;  /**< the size of the buffer */
+  uint32_t buf_pos;   /**< the next read position in the buffer */
+  uint32_t buf_len;   /**< the number of bytes held in the buffer */
 } dev_file_t;
 
+#if !defined(DEV_FILE_BUFFER_SIZE)
+#define DEV_FILE_BUFFER_SIZE 16384 /**< stream buffer size, 0 to disable buffering @ingroup dev_f */
+#endif
+
 // flags for dev_fopen()
 #define DEV_FILE_INPUT    1 /**< dev_fopen() flags, open file for input (read-only)     @ingroup dev_f */
 #define DEV_FILE_OUTPUT   2 /**< dev_fopen() flags, open file for output (create)     @ingroup dev_f */
@@ -930,6 +939,17 @@ int dev_fwrite(int SBHandle, byte *buff, uint32_t size);
  */
 int dev_fread(int SBHandle, byte *buff, uint32_t size);
 
+/**
+ * @ingroup dev_f
+ *
+ * reads the next line from the file, excluding the CR/LF characters
+ *
+ * @param SBHandle is the RTL's file-handle
+ * @param length receives the length of the text
+ * @return on success the text in a new buffer, otherwise NULL
+ */
+char *dev_freadln(int SBHandle, uint32_t *length);
+
 /**
  * @ingroup dev_f
  *
@@ -15,6 +15,8 @@
 #include "common/device.h"
 #include "common/extlib.h"
 #include "common/var_eval.h"
+#include "common/blib_math.h"
+#include "common/profile.h"
 
 #define IP           prog_ip
 #define CODE(x)      prog_source[(x)]
@@ -58,13 +60,22 @@ var_num_t *mat_toc(var_t *v, int32_t *rows, int32_t *cols) {
     *rows = 1;
   }
 
-  m = (var_num_t *)malloc(((*rows) * (*cols)) * sizeof(var_num_t));
-  for (int i = 0; i < *rows; i++) {
-    for (int j = 0; j < *cols; j++) {
-      int pos = i * (*cols) + j;
-      var_t *e = v_elem(v, pos);
-      m[pos] = v_getval(e);
+  int size = (*rows) * (*cols);
+  m = (var_num_t *)malloc(size * sizeof(var_num_t));
+  switch (v_packed(v)) {
+  case V_PACKED_NUM:
+    memcpy(m, v_pdata(v), size * sizeof(var_num_t));
+    break;
+  case V_PACKED_INT:
+    for (int pos = 0; pos < size; pos++) {
+      m[pos] = v_pdata(v)[pos].i;
     }
+    break;
+  default:
+    for (int pos = 0; pos < size; pos++) {
+      m[pos] = v_getval(&v_data(v)[pos]);
+    }
+    break;
   }
 
   return m;
@@ -74,18 +85,18 @@ var_num_t *mat_toc(var_t *v, int32_t *rows, int32_t *cols) {
  * matrix: conv. double[nr][nc] to var_t
  */
 void mat_tov(var_t *v, var_num_t *m, int rows, int cols, int protect_col1) {
+  v_free(v);
+  v_new_packed_array(v, rows * cols);
+  v_packed(v) = V_PACKED_NUM;
+  memcpy(v_pdata(v), m, rows * cols * sizeof(var_num_t));
+  v_lbound(v, 0) = opt_base;
+  v_ubound(v, 0) = opt_base + (rows - 1);
   if (cols > 1 || protect_col1) {
-    v_tomatrix(v, rows, cols);
+    v_maxdim(v) = 2;
+    v_lbound(v, 1) = opt_base;
+    v_ubound(v, 1) = opt_base + (cols - 1);
   } else {
-    v_toarray1(v, rows);
-  }
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      int pos = i * cols + j;
-      var_t *e = v_elem(v, pos);
-      e->type = V_NUM;
-      e->v.n = m[pos];
-    }
+    v_maxdim(v) = 1;
   }
 }
 
@@ -148,17 +159,17 @@ void mat_op2(var_t *l, var_t *r, int op) {
       if (rc != lc || lr != rr) {
         err_matdim();
       } else {
-        m = (var_num_t *)malloc(sizeof(var_num_t) * lr * lc);
-        for (int i = 0; i < lr; i++) {
-          for (int j = 0; j < lc; j++) {
-            int pos = i * lc + j;
-            if (op == '+') {
-              m[pos] = m1[pos] + m2[pos];
-            } else {
-              m[pos] = m2[pos] - m1[pos];
-            }
-            // array is comming reversed because of
-            // where to store
+        int size = lr * lc;
+        m = (var_num_t *)malloc(sizeof(var_num_t) * size);
+        // array is comming reversed because of
+        // where to store
+        if (op == '+') {
+          for (int pos = 0; pos < size; pos++) {
+            m[pos] = m1[pos] + m2[pos];
+          }
+        } else {
+          for (int pos = 0; pos < size; pos++) {
+            m[pos] = m2[pos] - m1[pos];
           }
         }
       }
@@ -193,8 +204,9 @@ void mat_sub(var_t *l, var_t *r) {
 void mat_mul_1d(var_t *l, var_t *r) {
   uint32_t size = v_asize(l);
   for (uint32_t i = 0; i < size; i++) {
+    var_t tmp;
     var_t *elem = v_elem(r, i);
-    var_num_t v1 = v_getval(v_elem(l, i));
+    var_num_t v1 = v_getval(v_elem_get(l, i, &tmp));
     var_num_t v2 = v_getval(elem);
     v_setreal(elem, (v1 * v2));
   }
@@ -207,8 +219,9 @@ void mat_dot(var_t *l, var_t *r) {
   var_num_t result = 0;
   uint32_t size = v_asize(l);
   for (uint32_t i = 0; i < size; i++) {
-    var_num_t v1 = v_getval(v_elem(l, i));
-    var_num_t v2 = v_getval(v_elem(r, i));
+    var_t tmp1, tmp2;
+    var_num_t v1 = v_getval(v_elem_get(l, i, &tmp1));
+    var_num_t v2 = v_getval(v_elem_get(r, i, &tmp2));
     result += (v1 * v2);
   }
   v_setreal(r, result);
@@ -233,15 +246,7 @@ void mat_mul(var_t *l, var_t *r) {
         mr = lr;
         mc = rc;
         m = (var_num_t *)malloc(sizeof(var_num_t) * mr * mc);
-        for (int i = 0; i < mr; i++) {
-          for (int j = 0; j < mc; j++) {
-            int pos = i * mc + j;
-            m[pos] = 0.0;
-            for (int k = 0; k < lc; k++) {
-              m[pos] = m[pos] + (m1[i * lc + k] * m2[k * rc + j]);
-            }
-          }
-        }
+        mat_product(m1, m2, m, mr, lc, mc);
       }
       free(m1);
       free(m2);
@@ -274,7 +279,8 @@ int v_wc_match(var_t *vwc, var_t *v) {
     int i;
     ri = 1;
     for (i = 0; i < v_asize(v); i++) {
-      var_t *elem_p = v_elem(v, i);
+      var_t tmp;
+      var_t *elem_p = v_elem_get(v, i, &tmp);
       if (v_wc_match(vwc, elem_p) == 0) {
         ri = 0;
         break;
@@ -294,9 +300,7 @@ int v_wc_match(var_t *vwc, var_t *v) {
   return ri;
 }
 
-static inline void oper_add(var_t *r, var_t *left) {
-  byte op = CODE(IP);
-  IP++;
+static inline void oper_add_op(var_t *r, var_t *left, byte op) {
   if (r->type == V_INT && v_is_type(left, V_INT)) {
     if (op == '+') {
       r->v.i += left->v.i;
@@ -359,6 +363,16 @@ static inline void oper_add(var_t *r, var_t *left) {
   }
 }
 
+static inline void oper_add(var_t *r, var_t *left) {
+  byte op = CODE(IP);
+  IP++;
+  oper_add_op(r, left, op);
+}
+
+void eval_add(var_t *r, var_t *left) {
+  oper_add_op(r, left, '+');
+}
+
 static inline void oper_mul(var_t *r, var_t *left) {
   var_num_t lf;
   var_num_t rf;
@@ -620,7 +634,8 @@ static inline void oper_cmp(var_t *r, var_t *left) {
     if (r->type == V_ARRAY) {
       int i;
       for (i = 0; i < v_asize(r); i++) {
-        var_t *elem_p = v_elem(r, i);
+        var_t tmp;
+        var_t *elem_p = v_elem_get(r, i, &tmp);
         if (v_compare(left, elem_p) == 0) {
           ri = i + 1;
           break;
@@ -780,8 +795,6 @@ static inline void eval_var(var_t *r, var_t *var_p) {
 }
 
 static inline void eval_push(var_t *r) {
-  bcip_t len;
-
   switch (r->type) {
   case V_INT:
     eval_stk[eval_sp].type = V_INT;
@@ -791,14 +804,6 @@ static inline void eval_push(var_t *r) {
     eval_stk[eval_sp].type = V_NUM;
     eval_stk[eval_sp].v.n = r->v.n;
     break;
-  case V_STR:
-    len = r->v.p.length;
-    eval_stk[eval_sp].type = V_STR;
-    eval_stk[eval_sp].v.p.ptr = malloc(len + 1);
-    eval_stk[eval_sp].v.p.owner = 1;
-    strcpy(eval_stk[eval_sp].v.p.ptr, r->v.p.ptr);
-    eval_stk[eval_sp].v.p.length = len;
-    break;
   default:
     v_set(&eval_stk[eval_sp], r);
   }
@@ -1218,84 +1223,140 @@ static inline void eval_callf(var_t *r) {
   }
 }
 
+/**
+ * evaluate the packed or shared array element, the array may have been
+ * unpacked while evaluating the index. the element is read in place
+ * without unsharing the array
+ */
+static void eval_packed(var_t *r, var_t *array) {
+  var_t *var_p;
+  bcip_t idx = code_get_packed_idx(array, &var_p);
+  if (idx == INVALID_ADDR) {
+    if (var_p != NULL) {
+      eval_var(r, var_p);
+    }
+  } else if (v_packed(array)) {
+    v_packed_get(array, idx, r);
+  } else {
+    eval_var(r, &v_data(array)[idx]);
+  }
+}
+
+/*
+ * ends an eval() handler. with USE_COMPUTED_GOTO the next code is dispatched
+ * from here rather than from the head of the loop
+ */
+#if defined(USE_COMPUTED_GOTO)
+#define EV_NEXT                          \
+  if (!prog_error) {                     \
+    code = prog_source[prog_ip];         \
+    goto *ev_table[code];                \
+  }                                      \
+  break
+#else
+#define EV_NEXT break
+#endif
+
 /**
  * executes the expression (Code[IP]) and returns the result (r)
  */
 void eval(var_t *r) {
   var_t *left = NULL;
+  var_t eval_left;
   bcip_t eval_pos = eval_sp;
   byte level = 0;
 
+#if defined(USE_COMPUTED_GOTO)
+  static const void *const ev_table[256] = {
+    [0 ... 255] = &&ev_switch,
+    DISPATCH_ENTRY(ev, kwTYPE_INT), DISPATCH_ENTRY(ev, kwTYPE_NUM),
+    DISPATCH_ENTRY(ev, kwTYPE_STR), DISPATCH_ENTRY(ev, kwTYPE_LOGOPR),
+    DISPATCH_ENTRY(ev, kwTYPE_CMPOPR), DISPATCH_ENTRY(ev, kwTYPE_ADDOPR),
+    DISPATCH_ENTRY(ev, kwTYPE_MULOPR), DISPATCH_ENTRY(ev, kwTYPE_POWOPR),
+    DISPATCH_ENTRY(ev, kwTYPE_UNROPR), DISPATCH_ENTRY(ev, kwTYPE_VAR),
+    DISPATCH_ENTRY(ev, kwTYPE_LEVEL_BEGIN), DISPATCH_ENTRY(ev, kwTYPE_LEVEL_END),
+    DISPATCH_ENTRY(ev, kwTYPE_EVPUSH), DISPATCH_ENTRY(ev, kwTYPE_EVPOP),
+    DISPATCH_ENTRY(ev, kwTYPE_EVAL_SC), DISPATCH_ENTRY(ev, kwTYPE_CALLF),
+    DISPATCH_ENTRY(ev, kwTYPE_CALL_UDF), DISPATCH_ENTRY(ev, kwTYPE_EVOPR)
+  };
+#endif
+
   while (!prog_error) {
     byte code = prog_source[prog_ip];
+    DISPATCH(ev, code);
     switch (code) {
-    case kwTYPE_INT:
+    DISPATCH_CASE(ev, kwTYPE_INT):
       // integer - constant
       IP++;
       V_FREE(r);
       r->type = V_INT;
       r->v.i = code_getint();
-      break;
+      EV_NEXT;
 
-    case kwTYPE_NUM:
+    DISPATCH_CASE(ev, kwTYPE_NUM):
       // double - constant
       IP++;
       V_FREE(r);
       r->type = V_NUM;
       r->v.n = code_getreal();
-      break;
+      EV_NEXT;
 
-    case kwTYPE_STR:
+    DISPATCH_CASE(ev, kwTYPE_STR):
       // string - constant
       IP++;
       V_FREE(r);
       v_eval_str(r);
-      break;
+      EV_NEXT;
 
-    case kwTYPE_LOGOPR:
+    DISPATCH_CASE(ev, kwTYPE_LOGOPR):
       IP++;
       oper_log(r, left);
-      break;
+      EV_NEXT;
 
-    case kwTYPE_CMPOPR:
+    DISPATCH_CASE(ev, kwTYPE_CMPOPR):
       IP++;
       oper_cmp(r, left);
-      break;
+      EV_NEXT;
 
-    case kwTYPE_ADDOPR:
+    DISPATCH_CASE(ev, kwTYPE_ADDOPR):
       IP++;
       oper_add(r, left);
-      break;
+      EV_NEXT;
 
-    case kwTYPE_MULOPR:
+    DISPATCH_CASE(ev, kwTYPE_MULOPR):
       IP++;
       oper_mul(r, left);
-      break;
+      EV_NEXT;
 
-    case kwTYPE_POWOPR:
+    DISPATCH_CASE(ev, kwTYPE_POWOPR):
       IP++;
       oper_powr(r, left);
-      break;
+      EV_NEXT;
 
-    case kwTYPE_UNROPR:
+    DISPATCH_CASE(ev, kwTYPE_UNROPR):
       // unary
       IP++;
       oper_unary(r);
-      break;
+      EV_NEXT;
 
-    case kwTYPE_VAR:
+    DISPATCH_CASE(ev, kwTYPE_VAR):
       // variable
       V_FREE(r);
-      eval_var(r, code_getvarptr());
-      break;
+      var_t *var_p = code_getvar_packed();
+      if (var_p != NULL) {
+        eval_packed(r, var_p);
+      } else {
+        eval_var(r, code_getvarptr());
+      }
+      EV_NEXT;
 
-    case kwTYPE_LEVEL_BEGIN:
+    DISPATCH_CASE(ev, kwTYPE_LEVEL_BEGIN):
       // left parenthesis
       IP++;
       level++;
-      break;
+      EV_NEXT;
 
-    case kwTYPE_LEVEL_END:
+    DISPATCH_CASE(ev, kwTYPE_LEVEL_END):
       // right parenthesis
       if (level == 0) {
         eval_sp = eval_pos;
@@ -1304,15 +1365,15 @@ void eval(var_t *r) {
       }
       level--;
       IP++;
-      break;
+      EV_NEXT;
 
-    case kwTYPE_EVPUSH:
+    DISPATCH_CASE(ev, kwTYPE_EVPUSH):
       // stack = push result
       IP++;
       eval_push(r);
-      break;
+      EV_NEXT;
 
-    case kwTYPE_EVPOP:
+    DISPATCH_CASE(ev, kwTYPE_EVPOP):
       // pop left
       IP++;
       if (!eval_sp) {
@@ -1321,22 +1382,60 @@ void eval(var_t *r) {
         eval_sp--;
         left = &eval_stk[eval_sp];
       }
-      break;
+      EV_NEXT;
+
+    DISPATCH_CASE(ev, kwTYPE_EVOPR):
+      // R moves to the left side, then R = constant or variable and
+      // the kwTYPE_EVPOP is skipped, see cev_add_opr() in ceval.c
+      IP++;
+      eval_left = *r;
+      v_init(r);
+      switch (CODE(IP)) {
+      case kwTYPE_INT:
+        IP++;
+        r->v.i = code_getint();
+        break;
+      case kwTYPE_NUM:
+        IP++;
+        r->type = V_NUM;
+        r->v.n = code_getreal();
+        break;
+      case kwTYPE_STR:
+        IP++;
+        v_eval_str(r);
+        break;
+      default:
+        eval_var(r, code_getvarptr());
+        break;
+      }
+      IP++;
+      left = &eval_left;
+      if (prog_error) {
+        V_FREE(left);
+      }
+      EV_NEXT;
 
-    case kwTYPE_EVAL_SC:
+    DISPATCH_CASE(ev, kwTYPE_EVAL_SC):
       IP++;
       eval_shortc(r);
-      break;
+      EV_NEXT;
 
-    case kwTYPE_CALLF:
+    DISPATCH_CASE(ev, kwTYPE_CALLF):
       // built-in functions
       IP++;
-      eval_callf(r);
-      break;
+      if (opt_profile) {
+        profile_enter_builtin(code_peekaddr(IP));
+        eval_callf(r);
+        profile_leave_builtin();
+      } else {
+        eval_callf(r);
+      }
+      evt_instr_count += EVT_CALLF_COST;
+      EV_NEXT;
 
-    case kwTYPE_CALL_UDF:
+    DISPATCH_CASE(ev, kwTYPE_CALL_UDF):
       eval_call_udf(r);
-      break;
+      EV_NEXT;
 
     default:
       // less used codes
@@ -1345,6 +1444,7 @@ void eval(var_t *r) {
         // [lib][index] external functions
         IP++;
         eval_extf(r);
+        EVT_CHECK_SOON();
         break;
 
       case kwTYPE_PTR:
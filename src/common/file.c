@@ -307,6 +307,47 @@ int dev_fread(int sb_handle, byte *data, uint32_t size) {
   return 0;
 }
 
+/**
+ * reads the next line excluding the CR/LF characters, returns the text
+ * in a new buffer or NULL on error
+ */
+char *dev_freadln(int sb_handle, uint32_t *length) {
+  dev_file_t *f;
+
+  if ((f = dev_getfileptr(sb_handle)) == NULL) {
+    return NULL;
+  }
+
+  if (f->type == ft_stream && f->buffer != NULL) {
+    return stream_readln(f, length);
+  }
+
+  uint32_t size = 256;
+  uint32_t index = 0;
+  char *result = malloc(size);
+  byte ch;
+
+  while (!dev_feof(sb_handle)) {
+    dev_fread(sb_handle, &ch, 1);
+    if (prog_error) {
+      free(result);
+      return NULL;
+    } else if (ch == '\n') {
+      break;
+    } else if (ch != '\r') {
+      // store char
+      if (index == (size - 1)) {
+        size += 256;
+        result = realloc(result, size);
+      }
+      result[index++] = ch;
+    }
+  }
+  result[index] = '\0';
+  *length = index;
+  return result;
+}
+
 /**
  *
  */
@@ -129,6 +129,7 @@ int http_read(dev_file_t *f, var_t *var_p) {
   var_p->type = V_STR;
   var_p->v.p.ptr = 0;
   var_p->v.p.length = 0;
+  var_p->v.p.owner = 1;
 
   while (1) {
     int bytes = net_read(f->handle, (char *) rxbuff, sizeof(rxbuff));
@@ -15,6 +15,8 @@
 
 #if defined(_UnixOS)
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 #include <dirent.h>
@@ -80,16 +82,66 @@ int stream_open(dev_file_t *f) {
 
   if (f->handle < 0) {
     err_file((f->last_error = errno));
+  } else if (f->handle > 2 && DEV_FILE_BUFFER_SIZE) {
+    // buffer regular files, the standard handles remain unbuffered
+    f->buf_size = DEV_FILE_BUFFER_SIZE;
+    f->buffer = malloc(f->buf_size);
   }
+  f->buf_pos = 0;
+  f->buf_len = 0;
   return (f->handle >= 0);
 }
 
+/*
+ * returns true when the buffer holds data for reading
+ */
+static inline int stream_is_input(dev_file_t *f) {
+  return !(f->open_flags & (DEV_FILE_OUTPUT | DEV_FILE_APPEND));
+}
+
+/*
+ * writes any pending output
+ */
+static int stream_flush(dev_file_t *f) {
+  int result = 1;
+  if (f->buffer != NULL && !stream_is_input(f) && f->buf_len) {
+    int r = write(f->handle, f->buffer, f->buf_len);
+    if (r != (int) f->buf_len) {
+      err_file((f->last_error = errno));
+      result = 0;
+    }
+    f->buf_len = 0;
+  }
+  return result;
+}
+
+/*
+ * refills the input buffer, returns the number of bytes available
+ */
+static uint32_t stream_fill(dev_file_t *f) {
+  if (f->buf_pos == f->buf_len) {
+    int r = read(f->handle, f->buffer, f->buf_size);
+    if (r < 0) {
+      err_file((f->last_error = errno));
+      r = 0;
+    }
+    f->buf_pos = 0;
+    f->buf_len = r;
+  }
+  return f->buf_len - f->buf_pos;
+}
+
 /*
  *   close the stream
  */
 int stream_close(dev_file_t *f) {
   int r;
 
+  stream_flush(f);
+  free(f->buffer);
+  f->buffer = NULL;
+  f->buf_len = 0;
+
   r = close(f->handle);
   f->handle = -1;
   if (r) {
@@ -103,6 +155,17 @@ int stream_close(dev_file_t *f) {
 int stream_write(dev_file_t *f, byte *data, uint32_t size) {
   int r;
 
+  if (f->buffer != NULL && !stream_is_input(f)) {
+    if (f->buf_len + size > f->buf_size && !stream_flush(f)) {
+      return 0;
+    }
+    if (size < f->buf_size) {
+      memcpy(f->buffer + f->buf_len, data, size);
+      f->buf_len += size;
+      return 1;
+    }
+  }
+
   r = write(f->handle, data, size);
   if (r != (int) size) {
     err_file((f->last_error = errno));
@@ -115,6 +178,27 @@ int stream_write(dev_file_t *f, byte *data, uint32_t size) {
 int stream_read(dev_file_t *f, byte *data, uint32_t size) {
   int r;
 
+  if (f->buffer != NULL && stream_is_input(f)) {
+    // take what is available from the buffer
+    uint32_t count = I2MIN(size, f->buf_len - f->buf_pos);
+    memcpy(data, f->buffer + f->buf_pos, count);
+    f->buf_pos += count;
+    data += count;
+    size -= count;
+    if (size == 0) {
+      return 1;
+    }
+    if (size < f->buf_size) {
+      count = I2MIN(size, stream_fill(f));
+      memcpy(data, f->buffer + f->buf_pos, count);
+      f->buf_pos += count;
+      if (count != size) {
+        err_file((f->last_error = errno));
+      }
+      return (count == size);
+    }
+  }
+
   r = read(f->handle, data, size);
   if (r != (int) size) {
     err_file((f->last_error = errno));
@@ -122,11 +206,154 @@ int stream_read(dev_file_t *f, byte *data, uint32_t size) {
   return (r == (int) size);
 }
 
+/*
+ * reads up to the next line feed, returns the text excluding any CR or LF
+ * characters in a new buffer, or NULL on error
+ */
+char *stream_readln(dev_file_t *f, uint32_t *length) {
+  uint32_t size = 256;
+  uint32_t len = 0;
+  char *result = malloc(size);
+  int eol = 0;
+
+  while (!eol && !prog_error && stream_fill(f)) {
+    byte *start = f->buffer + f->buf_pos;
+    uint32_t count = f->buf_len - f->buf_pos;
+    byte *lf = memchr(start, '\n', count);
+    if (lf != NULL) {
+      count = lf - start;
+      f->buf_pos++;
+      eol = 1;
+    }
+    f->buf_pos += count;
+    if (len + count >= size) {
+      size = len + count + 256;
+      result = realloc(result, size);
+    }
+    // copy the text, excluding any CR characters
+    byte *cr = memchr(start, '\r', count);
+    if (cr == NULL) {
+      memcpy(result + len, start, count);
+      len += count;
+    } else {
+      for (uint32_t i = 0; i < count; i++) {
+        if (start[i] != '\r') {
+          result[len++] = start[i];
+        }
+      }
+    }
+  }
+
+  if (prog_error) {
+    free(result);
+    result = NULL;
+  } else {
+    result[len] = '\0';
+    *length = len;
+  }
+  return result;
+}
+
+/*
+ * provides the remaining file contents from the current position, mapped
+ * into memory for regular files or otherwise read into a new buffer. the
+ * position is moved to the end of the file. release with stream_unmap().
+ * returns 0 with the position unchanged when the contents could not be
+ * provided, leaving the file to be read in the usual way
+ */
+int stream_map(dev_file_t *f, stream_map_t *map) {
+  map->base = NULL;
+  map->size = 0;
+  map->data = NULL;
+  map->length = 0;
+
+  if (!stream_flush(f)) {
+    return 0;
+  }
+  off_t pos = lseek(f->handle, 0, SEEK_CUR);
+  off_t size = pos == -1 ? -1 : lseek(f->handle, 0, SEEK_END);
+  if (size == -1 || (off_t)(size_t) size != size) {
+    if (pos != -1) {
+      lseek(f->handle, pos, SEEK_SET);
+    }
+    return 0;
+  }
+  if (f->buffer != NULL && stream_is_input(f)) {
+    // exclude the data read ahead into the buffer
+    pos -= (f->buf_len - f->buf_pos);
+  }
+  f->buf_pos = 0;
+  f->buf_len = 0;
+  map->length = pos < size ? size - pos : 0;
+  if (map->length == 0) {
+    return 1;
+  }
+
+#if defined(_UnixOS)
+  struct stat st;
+  if (fstat(f->handle, &st) == 0 && S_ISREG(st.st_mode)) {
+    void *addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, f->handle, 0);
+    if (addr != MAP_FAILED) {
+#if defined(MADV_SEQUENTIAL)
+      madvise(addr, size, MADV_SEQUENTIAL);
+#endif
+      map->base = addr;
+      map->size = size;
+      map->data = map->base + pos;
+      return 1;
+    }
+  }
+#endif
+
+  map->data = malloc(map->length);
+  if (map->data != NULL && lseek(f->handle, pos, SEEK_SET) == pos) {
+    size_t count = 0;
+    while (count < map->length) {
+      ssize_t r = read(f->handle, map->data + count, map->length - count);
+      if (r <= 0) {
+        break;
+      }
+      count += r;
+    }
+    if (count == map->length) {
+      return 1;
+    }
+  }
+  free(map->data);
+  map->data = NULL;
+  map->length = 0;
+  lseek(f->handle, pos, SEEK_SET);
+  return 0;
+}
+
+/*
+ * releases the stream_map() contents
+ */
+void stream_unmap(stream_map_t *map) {
+#if defined(_UnixOS)
+  if (map->base != NULL) {
+    munmap(map->base, map->size);
+    map->base = NULL;
+    map->data = NULL;
+  }
+#endif
+  free(map->data);
+  map->data = NULL;
+}
+
 /*
  * returns the current position
  */
 uint32_t stream_tell(dev_file_t *f) {
-  return lseek(f->handle, 0, SEEK_CUR);
+  uint32_t pos = lseek(f->handle, 0, SEEK_CUR);
+  if (f->buffer != NULL) {
+    if (stream_is_input(f)) {
+      pos -= (f->buf_len - f->buf_pos);
+    } else {
+      pos += f->buf_len;
+    }
+  }
+  return pos;
 }
 
 /*
@@ -135,6 +362,7 @@ uint32_t stream_tell(dev_file_t *f) {
 uint32_t stream_length(dev_file_t *f) {
   long pos, endpos;
 
+  stream_flush(f);
   pos = lseek(f->handle, 0, SEEK_CUR);
   if (pos != -1) {
     endpos = lseek(f->handle, 0, SEEK_END);
@@ -149,6 +377,9 @@ uint32_t stream_length(dev_file_t *f) {
 /*
  */
 uint32_t stream_seek(dev_file_t *f, uint32_t offset) {
+  stream_flush(f);
+  f->buf_pos = 0;
+  f->buf_len = 0;
   return lseek(f->handle, offset, SEEK_SET);
 }
 
@@ -157,6 +388,11 @@ uint32_t stream_seek(dev_file_t *f, uint32_t offset) {
 int stream_eof(dev_file_t *f) {
   long pos, endpos;
 
+  if (f->buffer != NULL && stream_is_input(f)) {
+    return (stream_fill(f) == 0);
+  }
+
+  stream_flush(f);
   pos = lseek(f->handle, 0, SEEK_CUR);
   if (pos != -1) {
     endpos = lseek(f->handle, 0, SEEK_END);
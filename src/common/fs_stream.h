@@ -13,13 +13,26 @@
 #include "common/sys.h"
 #include "common/device.h"
 
+/**
+ * remaining file contents, see stream_map()
+ */
+typedef struct stream_map_t {
+  char *base;       /**< the mapped region, NULL when data was read into memory */
+  size_t size;      /**< the size of the mapped region */
+  char *data;       /**< the contents from the file position */
+  size_t length;    /**< the number of bytes in data */
+} stream_map_t;
+
 int stream_open(dev_file_t *f);
 int stream_close(dev_file_t *f);
 int stream_write(dev_file_t *f, byte *data, uint32_t size);
 int stream_read(dev_file_t *f, byte *data, uint32_t size);
+char *stream_readln(dev_file_t *f, uint32_t *length);
 uint32_t stream_tell(dev_file_t *f);
 uint32_t stream_length(dev_file_t *f);
 uint32_t stream_seek(dev_file_t *f, uint32_t offset);
 int stream_eof(dev_file_t *f);
+int stream_map(dev_file_t *f, stream_map_t *map);
+void stream_unmap(stream_map_t *map);
 
 #endif
@@ -14,208 +14,212 @@
 #include "common/smbas.h"
 #include "common/hashmap.h"
 
-#define MAP_SIZE 32
+#define MAP_SIZE 16
+#define MAP_KEYS_SIZE 128
+#define MAP_EMPTY_SLOT 0
 
 /**
- * Our internal tree element node
+ * Map element. Entries are held in insertion order, the key text
+ * is stored in the owning map's key arena.
  */
-typedef struct Node {
-  var_p_t key;
+typedef struct MapEntry {
   var_p_t value;
-  struct Node *left, *right;
-} Node;
+  uint32_t hash;
+  uint32_t key;
+  uint32_t length;
+} MapEntry;
 
 /**
- * Returns a new tree node
+ * Open addressing table. slots[] holds the entry index + 1
+ * or MAP_EMPTY_SLOT, the table is resized to keep the load
+ * factor below 75%
  */
-Node *tree_create_node(var_p_t key) {
-  Node *node = (Node *)malloc(sizeof(Node));
-  node->key = key;
-  node->value = NULL;
-  node->left = NULL;
-  node->right = NULL;
-  return node;
-}
+typedef struct Map {
+  MapEntry *entries;
+  uint32_t *slots;
+  char *keys;
+  uint32_t keys_size;
+  uint32_t keys_used;
+  uint32_t capacity;
+  var_t key;
+} Map;
 
 /**
- * cleanup the given element
+ * Case insensitive FNV-1a
  */
-void tree_delete_node(Node *node) {
-  // cleanup v_new
-  v_free(node->key);
-  v_detach(node->key);
-
-  // cleanup v_new
-  if (node->value) {
-    v_free(node->value);
-    v_detach(node->value);
-  }
-
-  // cleanup the node
-  free(node);
-}
-
-static inline int tree_compare(const char *key, int length, var_p_t vkey) {
-  int len1 = length;
-  if (len1 && key[len1 - 1] == '\0') {
-    len1--;
+static inline uint32_t hashmap_get_hash(const char *key, int length) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < length; i++) {
+    hash ^= (uint8_t)to_lower(key[i]);
+    hash *= 16777619u;
   }
-  int len2 = vkey->v.p.length;
-  if (len2 && vkey->v.p.ptr[len2 - 1] == '\0') {
-    len2--;
-  }
-  return strcaselessn(key, len1, vkey->v.p.ptr, len2);
+  return hash;
 }
 
-void tree_destroy(Node *node) {
-  if (node->left != NULL) {
-    tree_destroy(node->left);
-  }
-  if (node->right != NULL) {
-    tree_destroy(node->right);
+/**
+ * Returns the key length excluding any trailing null
+ */
+static inline int hashmap_key_length(const char *key, int length) {
+  if (length && key[length - 1] == '\0') {
+    length--;
   }
-  tree_delete_node(node);
+  return length;
 }
 
-Node *tree_search(Node **rootp, const char *key, int length) {
-  while (*rootp != NULL) {
-    int r = tree_compare(key, length, (*rootp)->key);
-    if (r == 0) {
-      return *rootp;
-    }
-    rootp = (r < 0) ? &(*rootp)->left : &(*rootp)->right;
+/**
+ * Returns the number of slots required to hold size elements
+ */
+static uint32_t hashmap_get_size(int size) {
+  uint32_t result = MAP_SIZE;
+  while (result * 3 < (uint32_t)size * 4) {
+    result <<= 1;
   }
-  Node *result = tree_create_node(NULL);
-  *rootp = result;
   return result;
 }
 
-Node *tree_find(Node **rootp, const char *key, int length) {
-  while (*rootp != NULL) {
-    int r = tree_compare(key, length, (*rootp)->key);
-    if (r == 0) {
-      return *rootp;
-    }
-    rootp = (r < 0) ? &(*rootp)->left : &(*rootp)->right;
-  }
-  return NULL;
+/**
+ * Returns the key var for the given entry. The key remains valid until the
+ * next call, and is flagged as owned so that v_set() will copy the text
+ */
+static var_p_t hashmap_key(Map *map, MapEntry *entry) {
+  var_p_t result = &map->key;
+  result->type = V_STR;
+  result->v.p.ptr = map->keys + entry->key;
+  result->v.p.length = entry->length + 1;
+  result->v.p.owner = 1;
+  return result;
 }
 
-int tree_foreach(const Node *nodep, hashmap_foreach_func func, hashmap_cb *data) {
-  if (nodep != NULL) {
-    if (nodep->left != NULL && !tree_foreach(nodep->left, func, data)) {
-      return 0;
-    }
-
-    if (func(data, nodep->key, nodep->value)) {
-      return 0;
+/**
+ * Returns the slot containing the key or the empty slot to use for insertion
+ */
+static inline uint32_t *hashmap_slot(var_p_t var_p, uint32_t hash, const char *key, int length) {
+  Map *map = (Map *)var_p->v.m.map;
+  uint32_t mask = var_p->v.m.size - 1;
+  uint32_t index = hash & mask;
+  while (1) {
+    uint32_t *slot = &map->slots[index];
+    if (*slot == MAP_EMPTY_SLOT) {
+      return slot;
     }
-
-    if (nodep->right != NULL && !tree_foreach(nodep->right, func, data)) {
-      return 0;
+    MapEntry *entry = &map->entries[*slot - 1];
+    if (entry->hash == hash && (int)entry->length == length &&
+        strcaselessn(key, length, map->keys + entry->key, length) == 0) {
+      return slot;
     }
+    index = (index + 1) & mask;
   }
-  return 1;
 }
 
 /**
- * initialise the variable as a map
+ * Rebuilds the slots with double the size, using the cached hash codes
  */
-void hashmap_create(var_p_t map, int size) {
-  v_free(map);
-  map->type = V_MAP;
-  map->v.m.count = 0;
-  if (size == 0) {
-    map->v.m.size = MAP_SIZE;
-  } else {
-    map->v.m.size = (size * 100) / 75;
+static void hashmap_grow(var_p_t var_p) {
+  Map *map = (Map *)var_p->v.m.map;
+  uint32_t size = var_p->v.m.size * 2;
+  uint32_t mask = size - 1;
+  free(map->slots);
+  map->slots = calloc(size, sizeof(uint32_t));
+  var_p->v.m.size = size;
+  for (uint32_t i = 0; i < var_p->v.m.count; i++) {
+    uint32_t index = map->entries[i].hash & mask;
+    while (map->slots[index] != MAP_EMPTY_SLOT) {
+      index = (index + 1) & mask;
+    }
+    map->slots[index] = i + 1;
   }
-  map->v.m.map = calloc(map->v.m.size, sizeof(Node *));
 }
 
-int hashmap_destroy(var_p_t var_p) {
-  if (var_p->type == V_MAP && var_p->v.m.map != NULL) {
-    Node **table = (Node **)var_p->v.m.map;
-    for (int i = 0; i < var_p->v.m.size; i++) {
-      if (table[i] != NULL) {
-        tree_destroy(table[i]);
-      }
+/**
+ * Appends the key text to the arena, returning its offset
+ */
+static uint32_t hashmap_add_key(Map *map, const char *key, int length) {
+  uint32_t required = map->keys_used + length + 1;
+  if (required > map->keys_size) {
+    uint32_t size = map->keys_size ? map->keys_size : MAP_KEYS_SIZE;
+    while (size < required) {
+      size *= 2;
     }
-    free(var_p->v.m.map);
+    map->keys = realloc(map->keys, size);
+    map->keys_size = size;
   }
-  return 0;
+  uint32_t result = map->keys_used;
+  memcpy(map->keys + result, key, length);
+  map->keys[result + length] = '\0';
+  map->keys_used = required;
+  return result;
 }
 
-int hashmap_get_hash(const char *key, int length) {
-  int hash = 1, i;
-  for (i = 0; i < length && key[i] != '\0'; i++) {
-    hash += to_lower(key[i]);
-    hash <<= 3;
-    hash ^= (hash >> 3);
+/**
+ * Returns the entry for the given key, adding a new entry when not found
+ */
+static MapEntry *hashmap_search(var_p_t var_p, const char *key, int length) {
+  Map *map = (Map *)var_p->v.m.map;
+  if ((var_p->v.m.count + 1) * 4 > var_p->v.m.size * 3) {
+    hashmap_grow(var_p);
   }
-  return hash;
-}
 
-static inline Node *hashmap_search(var_p_t map, const char *key, int length) {
-  int index = hashmap_get_hash(key, length) % map->v.m.size;
-  Node **table = (Node **)map->v.m.map;
-  Node *result = table[index];
-  if (result == NULL) {
-    // new entry
-    result = table[index] = tree_create_node(NULL);
+  length = hashmap_key_length(key, length);
+  uint32_t hash = hashmap_get_hash(key, length);
+  uint32_t *slot = hashmap_slot(var_p, hash, key, length);
+  MapEntry *result;
+  if (*slot != MAP_EMPTY_SLOT) {
+    result = &map->entries[*slot - 1];
   } else {
-    int r = tree_compare(key, length, result->key);
-    if (r < 0) {
-      result = tree_search(&result->left, key, length);
-    } else if (r > 0) {
-      result = tree_search(&result->right, key, length);
+    if (var_p->v.m.count == map->capacity) {
+      map->capacity *= 2;
+      map->entries = realloc(map->entries, map->capacity * sizeof(MapEntry));
     }
+    result = &map->entries[var_p->v.m.count++];
+    result->hash = hash;
+    result->key = hashmap_add_key(map, key, length);
+    result->length = length;
+    result->value = v_new();
+    *slot = var_p->v.m.count;
   }
   return result;
 }
 
-static inline Node *hashmap_find(var_p_t map, const char *key) {
-  int length = strlen(key);
-  int index = hashmap_get_hash(key, length) % map->v.m.size;
-  Node **table = (Node **)map->v.m.map;
-  Node *result = table[index];
-  if (result != NULL) {
-    int r = tree_compare(key, length, result->key);
-    if (r < 0 && result->left != NULL) {
-      result = tree_find(&result->left, key, length);
-    } else if (r > 0 && result->right != NULL) {
-      result = tree_find(&result->right, key, length);
-    } else if (r != 0) {
-      result = NULL;
+/**
+ * initialise the variable as a map
+ */
+void hashmap_create(var_p_t var_p, int size) {
+  v_free(var_p);
+  Map *map = (Map *)malloc(sizeof(Map));
+  var_p->type = V_MAP;
+  var_p->v.m.count = 0;
+  var_p->v.m.size = hashmap_get_size(size);
+  var_p->v.m.map = map;
+  map->capacity = (var_p->v.m.size * 3) / 4;
+  map->entries = malloc(map->capacity * sizeof(MapEntry));
+  map->slots = calloc(var_p->v.m.size, sizeof(uint32_t));
+  map->keys = NULL;
+  map->keys_size = 0;
+  map->keys_used = 0;
+  v_init(&map->key);
+}
+
+int hashmap_destroy(var_p_t var_p) {
+  if (var_p->type == V_MAP && var_p->v.m.map != NULL) {
+    Map *map = (Map *)var_p->v.m.map;
+    for (uint32_t i = 0; i < var_p->v.m.count; i++) {
+      v_free(map->entries[i].value);
+      v_detach(map->entries[i].value);
     }
+    free(map->entries);
+    free(map->slots);
+    free(map->keys);
+    free(map);
   }
-  return result;
+  return 0;
 }
 
 var_p_t hashmap_put(var_p_t map, const char *key, int length) {
-  Node *node = hashmap_search(map, key, length);
-  if (node->key == NULL) {
-    node->key = v_new();
-    node->value = v_new();
-    v_setstrn(node->key, key, length);
-    map->v.m.count++;
-  }
-  return node->value;
+  return hashmap_search(map, key, length)->value;
 }
 
 var_p_t hashmap_putc(var_p_t map, const char *key, int length) {
-  Node *node = hashmap_search(map, key, length);
-  if (node->key == NULL) {
-    var_t *var_key = v_new();
-    var_key->type = V_STR;
-    var_key->v.p.length = length;
-    var_key->v.p.ptr = (char *)key;
-    var_key->v.p.owner = 0;
-    node->key = var_key;
-    node->value = v_new();
-    map->v.m.count++;
-  }
-  return node->value;
+  return hashmap_search(map, key, length)->value;
 }
 
 var_p_t hashmap_putv(var_p_t map, const var_p_t key) {
@@ -224,39 +228,45 @@ var_p_t hashmap_putv(var_p_t map, const var_p_t key) {
     // keys are always strings
     v_tostr(key);
   }
+  var_p_t result = hashmap_search(map, key->v.p.ptr, key->v.p.length)->value;
 
-  Node *node = hashmap_search(map, key->v.p.ptr, key->v.p.length);
-  if (node->key == NULL) {
-    node->key = key;
-    node->value = v_new();
-    map->v.m.count++;
+  // the key text is held in the map
+  v_free(key);
+  v_detach(key);
+  return result;
+}
+
+var_p_t hashmap_get(var_p_t var_p, const char *key) {
+  var_p_t result;
+  int length = strlen(key);
+  uint32_t *slot = hashmap_slot(var_p, hashmap_get_hash(key, length), key, length);
+  if (*slot != MAP_EMPTY_SLOT) {
+    Map *map = (Map *)var_p->v.m.map;
+    result = map->entries[*slot - 1].value;
   } else {
-    // discard unused key
-    v_free(key);
-    v_detach(key);
+    result = NULL;
   }
-  return node->value;
+  return result;
 }
 
-var_p_t hashmap_get(var_p_t map, const char *key) {
+var_p_t hashmap_get_key(var_p_t var_p, int index) {
   var_p_t result;
-  Node *node = hashmap_find(map, key);
-  if (node != NULL) {
-    result = node->value;
+  if (index >= 0 && (uint32_t)index < var_p->v.m.count) {
+    Map *map = (Map *)var_p->v.m.map;
+    result = hashmap_key(map, &map->entries[index]);
   } else {
     result = NULL;
   }
   return result;
 }
 
-void hashmap_foreach(var_p_t map, hashmap_foreach_func func, hashmap_cb *data) {
-  if (map && map->type == V_MAP) {
-    Node **table = (Node **)map->v.m.map;
-    for (int i = 0; i < map->v.m.size; i++) {
-      if (table[i] != NULL) {
-        if (!tree_foreach(table[i], func, data)) {
-          break;
-        }
+void hashmap_foreach(var_p_t var_p, hashmap_foreach_func func, hashmap_cb *data) {
+  if (var_p && var_p->type == V_MAP) {
+    Map *map = (Map *)var_p->v.m.map;
+    for (uint32_t i = 0; i < var_p->v.m.count; i++) {
+      MapEntry *entry = &map->entries[i];
+      if (func(data, hashmap_key(map, entry), entry->value)) {
+        break;
       }
     }
   }
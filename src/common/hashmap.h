@@ -32,6 +32,7 @@ var_p_t hashmap_put(var_p_t map, const char *key, int length);
 var_p_t hashmap_putc(var_p_t map, const char *key, int length);
 var_p_t hashmap_putv(var_p_t map, const var_p_t key);
 var_p_t hashmap_get(var_p_t map, const char *key);
+var_p_t hashmap_get_key(var_p_t map, int index);
 void hashmap_foreach(var_p_t map, hashmap_foreach_func func, hashmap_cb *data);
 
 #endif /* !_HASHMAP_H_ */
@@ -158,6 +158,27 @@ static inline var_t *code_getvarptr_parens(int until_parens) {
   return var_p;
 }
 
+/**
+ * @ingroup exec
+ *
+ * returns the packed, shared or SEARCH indexed array variable at IP when
+ * followed by an index and moves the IP to the index, otherwise returns NULL
+ */
+static inline var_t *code_getvar_packed() {
+  var_t *var_p = NULL;
+  if (code_peek() == kwTYPE_VAR) {
+    var_p = tvar[code_peek32(prog_ip + 1)];
+    if (var_p->type == V_ARRAY &&
+        (v_packed(var_p) || v_shared(var_p) || v_data(var_p) == v_indexed_data) &&
+        prog_source[prog_ip + 1 + ADDRSZ] == kwTYPE_LEVEL_BEGIN) {
+      prog_ip += 1 + ADDRSZ;
+    } else {
+      var_p = NULL;
+    }
+  }
+  return var_p;
+}
+
 /**
  * @ingroup var
  *
@@ -196,7 +217,9 @@ static inline void v_detach(var_t *v) {
 static inline void v_free(var_t *v) {
   switch (v->type) {
   case V_STR:
-    if (v->v.p.owner) {
+    if (v->v.p.owner == V_STR_COUNTED) {
+      v_block_free(v->v.p.ptr);
+    } else if (v->v.p.owner) {
       free(v->v.p.ptr);
     }
     break;
@@ -209,3 +232,75 @@ static inline void v_free(var_t *v) {
   }
   v_init(v);
 }
+
+/**
+ * @ingroup exec
+ *
+ * replaces the variable vid with the frame slot's variable
+ */
+static inline var_t *frame_bind(frame_slot_t *slot, bid_t vid) {
+  var_t *var = &slot->var;
+  slot->vid = vid;
+  slot->vptr = tvar[vid];
+  tvar[vid] = var;
+  return var;
+}
+
+/**
+ * @ingroup exec
+ *
+ * replaces the variable vid with the empty frame slot
+ */
+static inline var_t *frame_install(frame_slot_t *slot, bid_t vid) {
+  slot->var.pooled = 0;
+  v_init(&slot->var);
+  return frame_bind(slot, vid);
+}
+
+/**
+ * @ingroup exec
+ *
+ * makes the pushed node a kwTYPE_CRVAR frame of count slots from the frame
+ * arena. each slot is then installed with frame_install()
+ *
+ * @return the first slot, or NULL on error
+ */
+static inline frame_slot_t *frame_alloc(stknode_t *node, uint32_t count) {
+  frame_block_t *block = prog_frame;
+  if (block == NULL || block->count + count > block->size) {
+    return frame_grow(node, count);
+  }
+  frame_slot_t *slots = &block->slots[block->count];
+  node->type = kwTYPE_CRVAR;
+  node->x.vframe.block = block;
+  node->x.vframe.slots = slots;
+  node->x.vframe.count = count;
+  block->count += count;
+  return slots;
+}
+
+/**
+ * @ingroup exec
+ *
+ * frees the frame variables, restores the previous variables and releases
+ * the slots. called again for the same node, eg from code_pop(), it has no
+ * further effect
+ */
+static inline void frame_free(stknode_t *node) {
+  frame_slot_t *slots = node->x.vframe.slots;
+  for (int i = (int)node->x.vframe.count - 1; i >= 0; i--) {
+    frame_slot_t *slot = &slots[i];
+    if (slot->vptr == NULL) {
+      // an argument not yet bound to its parameter
+      v_free(&slot->var);
+    } else if (tvar[slot->vid] == &slot->var) {
+      v_free(&slot->var);
+      tvar[slot->vid] = slot->vptr;
+    }
+  }
+  frame_block_t *block = node->x.vframe.block;
+  if (block != NULL) {
+    block->count = slots - block->slots;
+    prog_frame = block;
+  }
+}
@@ -45,6 +45,9 @@ extern "C" {
 #define OPLOG_LSHIFT    'X'     // LSHIFT
 #define OPLOG_RSHIFT    'Y'     // RSHIFT
 
+// the most terms of a kwLET_APPEND, which are all evaluated before any is appended
+#define LET_APPEND_TERMS 16
+
 /**
  * @ingroup sys
  * @enum keyword
@@ -178,6 +181,9 @@ enum keyword {                // line 50
   kwCATCH,
   kwENDTRY,
   kwFUNC_RETURN,
+  kwLET_APPEND,
+  kwLET_INC,
+  kwTYPE_EVOPR, /* POP L from R, then R = the following constant or variable */
   kwNULL
 };
 
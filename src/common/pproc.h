@@ -45,6 +45,41 @@ extern "C" {
 #define pfree4(a,b,c,d) { pfree3((a),(b),(c)); pfree((d)); }
 /**< simple macro for free() 4 ptrs @ingroup par */
 
+/*
+ * opcode dispatch for bc_loop() and eval()
+ *
+ * with USE_COMPUTED_GOTO each case label also gets a plain label which is
+ * entered directly from the t_table[] of label addresses. codes without a table
+ * entry land on t_switch and take the regular switch path.
+ */
+#if defined(USE_COMPUTED_GOTO)
+#define DISPATCH(t, c)       goto *t##_table[(c)]; t##_switch:
+#define DISPATCH_CASE(t, c)  case c: t##_##c
+#define DISPATCH_ENTRY(t, c) [c] = &&t##_##c
+#else
+#define DISPATCH(t, c)
+#define DISPATCH_CASE(t, c)  case c
+#endif
+
+/*
+ * events are polled once the commands run add up to EVT_CHECK_INSTR. a plain
+ * command costs one and takes in the order of 10-100ns, so 256 of them stay
+ * well inside the 50ms polling interval while the clock, a system call on
+ * some platforms, is read at most once per few microseconds of work. a
+ * built-in function counts as EVT_CALLF_COST and commands which may block
+ * use EVT_CHECK_SOON() to have the clock read before the next command
+ */
+#define EVT_CHECK_INSTR 256
+#define EVT_CALLF_COST 8
+#define EVT_CHECK_SOON() (evt_instr_count = EVT_CHECK_INSTR)
+
+/**
+ * @ingroup exec
+ *
+ * the cost of the commands run since the event clock was last read
+ */
+extern uint32_t evt_instr_count;
+
 /**
  * @ingroup exec
  *
@@ -64,6 +99,14 @@ void bc_loop(int isf);
  */
 void eval(var_t *result);
 
+/**
+ * @ingroup exec
+ *
+ * applies the '+' operator, result = left + result. left is released
+ * when not numeric
+ */
+void eval_add(var_t *result, var_t *left);
+
 /**
  * @ingroup exec
  *
@@ -385,6 +428,20 @@ void exec_usefunc(var_t *var, bcip_t ip);
  */
 void exec_usefunc2(var_t *var1, var_t *var2, bcip_t ip);
 
+/**
+ * @ingroup par
+ *
+ * execute a user's expression with X and Y referring to the given
+ * variables, without copying them. the variables must stay in place
+ * while the expression runs.
+ *
+ * @param result the expression result
+ * @param var1 the variable (the X)
+ * @param var2 the variable (the Y)
+ * @param ip the expression's address
+ */
+void exec_usefunc2_ref(var_t *result, var_t *var1, var_t *var2, bcip_t ip);
+
 /**
  * @ingroup par
  *
@@ -150,6 +150,30 @@ void exec_usefunc2(var_t *var1, var_t *var2, bcip_t ip) {
   v_detach(old_y);
 }
 
+/*
+ * execute a user's expression with X and Y referring to the given
+ * variables, without copying them. the caller must keep the variables
+ * in place while the expression runs, for example by holding a reference
+ * to the array they belong to
+ *
+ * result - the expression result
+ * var1   - the first variable (the X)
+ * var2   - the second variable (the Y)
+ * ip     - expression's address
+ */
+void exec_usefunc2_ref(var_t *result, var_t *var1, var_t *var2, bcip_t ip) {
+  var_t *old_x = tvar[SYSVAR_X];
+  var_t *old_y = tvar[SYSVAR_Y];
+
+  tvar[SYSVAR_X] = var1;
+  tvar[SYSVAR_Y] = var2;
+  code_jump(ip);
+  eval(result);
+
+  tvar[SYSVAR_X] = old_x;
+  tvar[SYSVAR_Y] = old_y;
+}
+
 void pv_write_str(char *str, var_t *vp) {
   vp->v.p.length += strlen(str);
   if (vp->v.p.ptr == NULL) {
@@ -436,7 +460,7 @@ var_t *par_next_str(var_t *arg, int sep) {
   var_t *result;
   if (prog_error) {
     result = NULL;
-  } else if (code_isvar()) {
+  } else if (code_isvar_inplace()) {
     result = code_getvarptr();
   } else {
     eval(arg);
@@ -536,7 +560,7 @@ pt_t par_getpt() {
   pt.x = pt.y = 0;
 
   // first parameter
-  if (code_isvar()) {
+  if (code_isvar_inplace()) {
     var = code_getvarptr();
   } else {
     alloc = 1;
@@ -550,8 +574,9 @@ pt_t par_getpt() {
       if (v_asize(var) != 2) {
         rt_raise(ERR_POLY_POINT);
       } else {
-        pt.x = v_getreal(v_elem(var, 0));
-        pt.y = v_getreal(v_elem(var, 1));
+        var_t elem;
+        pt.x = v_getreal(v_elem_get(var, 0, &elem));
+        pt.y = v_getreal(v_elem_get(var, 1, &elem));
       }
     } else {
       // non-arrays
@@ -588,7 +613,7 @@ ipt_t par_getipt() {
   pt.x = pt.y = 0;
 
   // first parameter
-  if (code_isvar()) {
+  if (code_isvar_inplace()) {
     var = code_getvarptr();
   } else {
     alloc = 1;
@@ -602,8 +627,9 @@ ipt_t par_getipt() {
       if (v_asize(var) != 2) {
         rt_raise(ERR_POLY_POINT);
       } else {
-        pt.x = v_getint(v_elem(var, 0));
-        pt.y = v_getint(v_elem(var, 1));
+        var_t elem;
+        pt.x = v_getint(v_elem_get(var, 0, &elem));
+        pt.y = v_getint(v_elem_get(var, 1, &elem));
       }
     } else {
       // non-arrays
@@ -0,0 +1,462 @@
+// This file is part of SmallBASIC
+//
+// Profiler: commands and time per source line, SUB/FUNC and built-in
+//
+// Costs are charged at line, call and return boundaries: everything
+// between two events belongs to the current line of the function on
+// top of the profile stack. Each call adds its inclusive cost to the
+// (caller, line, callee) edge, which is enough for a callgrind call-graph.
+//
+// This program is distributed under the terms of the GPL v2.0 or later
+// Download the GNU Public License (GPL) from www.gnu.org
+//
+// Copyright(C) 2026 The SmallBASIC authors.
+
+#include "common/sys.h"
+#include "common/kw.h"
+#include "common/var.h"
+#include "common/smbas.h"
+#include "common/device.h"
+#include "common/profile.h"
+
+#include <time.h>
+
+#define PROFILE_MAIN 0
+#define PROFILE_NO_SP -1
+#define PROFILE_TOP_LINES 20
+
+typedef struct profile_func_s {
+  char *name;
+  bcip_t ip;             // call target of a SUB/FUNC, INVALID_ADDR for built-ins
+  int line;              // source line of the definition
+  int active;            // open calls; inclusive cost is only counted once
+  uint32_t calls;
+  uint64_t self_commands;
+  uint64_t self_usec;
+  uint64_t total_commands;
+  uint64_t total_usec;
+} profile_func_t;
+
+typedef struct profile_cost_s {
+  int func;
+  int line;
+  int callee;            // -1 for the function's own cost
+  uint32_t calls;
+  uint64_t commands;
+  uint64_t usec;
+} profile_cost_t;
+
+typedef struct profile_frame_s {
+  int func;
+  int line;              // the caller's line
+  int sp;                // the call node, PROFILE_NO_SP for built-ins
+  uint64_t commands;
+  uint64_t usec;
+} profile_frame_t;
+
+uint64_t profile_commands;
+
+static struct {
+  profile_func_t *funcs;
+  int func_count;
+  int func_size;
+  int udp_count;
+  int *builtins;         // function index of each built-in code, or 0
+  profile_cost_t *costs;
+  int cost_count;
+  int cost_size;         // power of two, open addressing
+  profile_frame_t *stack;
+  int stack_count;
+  int stack_size;
+  int tid;
+  int line;
+  uint64_t commands;
+  uint64_t usec;
+  uint64_t start_usec;
+} profile;
+
+static uint64_t profile_usec() {
+#if defined(__MACH__) || defined(_Win32)
+  return (uint64_t)dev_get_millisecond_count() * 1000;
+#else
+  struct timespec t;
+  if (clock_gettime(CLOCK_MONOTONIC, &t) != 0) {
+    return (uint64_t)dev_get_millisecond_count() * 1000;
+  }
+  return (uint64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+#endif
+}
+
+static int profile_add_func(const char *name, bcip_t ip, int line) {
+  if (profile.func_count == profile.func_size) {
+    profile.func_size += 64;
+    profile.funcs = realloc(profile.funcs, profile.func_size * sizeof(profile_func_t));
+  }
+  profile_func_t *func = &profile.funcs[profile.func_count];
+  memset(func, 0, sizeof(profile_func_t));
+  func->name = strdup(name);
+  func->ip = ip;
+  func->line = line;
+  return profile.func_count++;
+}
+
+static inline uint32_t profile_hash(int func, int line, int callee) {
+  uint32_t h = (uint32_t)func * 0x9E3779B1u;
+  h ^= (uint32_t)line * 0x85EBCA77u;
+  h ^= (uint32_t)(callee + 1) * 0xC2B2AE3Du;
+  return h ^ (h >> 15);
+}
+
+static profile_cost_t *profile_cost(int func, int line, int callee) {
+  if (profile.cost_count * 2 >= profile.cost_size) {
+    // grow and rehash
+    profile_cost_t *old = profile.costs;
+    int old_size = profile.cost_size;
+    profile.cost_size = old_size ? old_size * 2 : 1024;
+    profile.costs = malloc(profile.cost_size * sizeof(profile_cost_t));
+    for (int i = 0; i < profile.cost_size; i++) {
+      profile.costs[i].func = -1;
+    }
+    for (int i = 0; i < old_size; i++) {
+      if (old[i].func != -1) {
+        uint32_t j = profile_hash(old[i].func, old[i].line, old[i].callee);
+        while (profile.costs[j &= profile.cost_size - 1].func != -1) {
+          j++;
+        }
+        profile.costs[j] = old[i];
+      }
+    }
+    free(old);
+  }
+  uint32_t i = profile_hash(func, line, callee);
+  for (;;) {
+    profile_cost_t *cost = &profile.costs[i &= profile.cost_size - 1];
+    if (cost->func == -1) {
+      cost->func = func;
+      cost->line = line;
+      cost->callee = callee;
+      cost->calls = 0;
+      cost->commands = 0;
+      cost->usec = 0;
+      profile.cost_count++;
+      return cost;
+    }
+    if (cost->func == func && cost->line == line && cost->callee == callee) {
+      return cost;
+    }
+    i++;
+  }
+}
+
+/**
+ * charges everything since the last event to the current line
+ */
+static void profile_charge() {
+  uint64_t now = profile_usec();
+  uint64_t commands = profile_commands - profile.commands;
+  uint64_t usec = now - profile.usec;
+  if (commands || usec) {
+    int func = profile.stack_count ? profile.stack[profile.stack_count - 1].func : PROFILE_MAIN;
+    profile_cost_t *cost = profile_cost(func, profile.line, -1);
+    cost->commands += commands;
+    cost->usec += usec;
+    profile.funcs[func].self_commands += commands;
+    profile.funcs[func].self_usec += usec;
+  }
+  profile.commands = profile_commands;
+  profile.usec = now;
+}
+
+static void profile_push(int func, int sp) {
+  if (profile.stack_count == profile.stack_size) {
+    profile.stack_size += 64;
+    profile.stack = realloc(profile.stack, profile.stack_size * sizeof(profile_frame_t));
+  }
+  profile_frame_t *frame = &profile.stack[profile.stack_count++];
+  frame->func = func;
+  frame->line = profile.line;
+  frame->sp = sp;
+  frame->commands = profile.commands;
+  frame->usec = profile.usec;
+  profile.funcs[func].calls++;
+  profile.funcs[func].active++;
+  profile.line = profile.funcs[func].line;
+}
+
+/**
+ * closes the top frame; profile_charge() must be called first
+ */
+static void profile_pop() {
+  profile_frame_t *frame = &profile.stack[--profile.stack_count];
+  profile_func_t *func = &profile.funcs[frame->func];
+  int caller = profile.stack_count ? profile.stack[profile.stack_count - 1].func : PROFILE_MAIN;
+  uint64_t commands = profile.commands - frame->commands;
+  uint64_t usec = profile.usec - frame->usec;
+  profile_cost_t *edge = profile_cost(caller, frame->line, frame->func);
+  edge->calls++;
+  edge->commands += commands;
+  edge->usec += usec;
+  if (--func->active == 0) {
+    func->total_commands += commands;
+    func->total_usec += usec;
+  }
+  profile.line = frame->line;
+}
+
+/**
+ * closes calls that were left without a RETURN, eg by an error or CATCH
+ */
+static void profile_unwind() {
+  while (profile.stack_count) {
+    profile_frame_t *frame = &profile.stack[profile.stack_count - 1];
+    if (frame->sp == PROFILE_NO_SP || frame->sp < prog_stack_count) {
+      break;
+    }
+    profile_pop();
+  }
+}
+
+static int profile_find_udp(bcip_t ip) {
+  int lo = 1;
+  int hi = profile.udp_count;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (profile.funcs[mid].ip == ip) {
+      return mid;
+    } else if (profile.funcs[mid].ip < ip) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  // compiled elsewhere, eg a cached .sbx
+  for (int i = profile.udp_count + 1; i < profile.func_count; i++) {
+    if (profile.funcs[i].ip == ip) {
+      return i;
+    }
+  }
+  char name[32];
+  sprintf(name, "sub@%u", ip);
+  return profile_add_func(name, ip, 0);
+}
+
+static int profile_cmp_udp(const void *a, const void *b) {
+  bcip_t ip_a = ((const profile_func_t *)a)->ip;
+  bcip_t ip_b = ((const profile_func_t *)b)->ip;
+  return ip_a < ip_b ? -1 : ip_a > ip_b;
+}
+
+void profile_add_udp(const char *name, bcip_t ip, int line) {
+  if (!profile.func_count) {
+    profile_add_func("main", INVALID_ADDR, 0);
+  }
+  profile_add_func(name, ip, line);
+}
+
+void profile_begin(int tid) {
+  if (!profile.func_count) {
+    profile_add_func("main", INVALID_ADDR, 0);
+  }
+  profile.udp_count = profile.func_count - 1;
+  qsort(profile.funcs + 1, profile.udp_count, sizeof(profile_func_t), profile_cmp_udp);
+  profile.builtins = calloc(kwNULLFUNC - kwCLS, sizeof(int));
+  profile.tid = tid;
+  profile.line = 0;
+  profile.stack_count = 0;
+  profile_commands = 0;
+  profile.commands = 0;
+  profile.start_usec = profile.usec = profile_usec();
+  profile.funcs[PROFILE_MAIN].calls = 1;
+}
+
+void profile_end() {
+  if (profile.builtins != NULL) {
+    profile_charge();
+    while (profile.stack_count) {
+      profile_pop();
+    }
+    profile_func_t *top = &profile.funcs[PROFILE_MAIN];
+    top->total_commands = profile.commands;
+    top->total_usec = profile.usec - profile.start_usec;
+  }
+}
+
+void profile_line(int line) {
+  if (ctask->tid == profile.tid) {
+    profile_charge();
+    profile_unwind();
+    profile.line = line;
+  }
+}
+
+void profile_enter(bcip_t ip) {
+  if (ctask->tid == profile.tid) {
+    profile_charge();
+    profile_push(profile_find_udp(ip), prog_stack_count - 1);
+  }
+}
+
+void profile_leave() {
+  if (ctask->tid == profile.tid) {
+    // the call node has been popped, so its frame is closed with any stale ones
+    profile_charge();
+    profile_unwind();
+  }
+}
+
+void profile_enter_builtin(bid_t code) {
+  if (ctask->tid == profile.tid && code >= kwCLS && code < kwNULLFUNC) {
+    int *func = &profile.builtins[code - kwCLS];
+    if (!*func) {
+      char name[SB_KEYWORD_SIZE + 1];
+      if (code < kwASC) {
+        kw_getprocname(code, name);
+      } else {
+        kw_getfuncname(code, name);
+      }
+      *func = profile_add_func(name, INVALID_ADDR, 0);
+    }
+    profile_charge();
+    profile_push(*func, PROFILE_NO_SP);
+  }
+}
+
+void profile_leave_builtin() {
+  if (ctask->tid == profile.tid) {
+    profile_charge();
+    while (profile.stack_count && profile.stack[profile.stack_count - 1].sp != PROFILE_NO_SP) {
+      // a SUB or FUNC called from the built-in did not return
+      profile_pop();
+    }
+    if (profile.stack_count) {
+      profile_pop();
+    }
+  }
+}
+
+int profile_write(const char *file_name) {
+  FILE *fp = fopen(file_name, "w");
+  if (fp == NULL) {
+    return 0;
+  }
+  fprintf(fp, "# callgrind format\n");
+  fprintf(fp, "version: 1\n");
+  fprintf(fp, "creator: SmallBASIC %s\n", SB_STR_VER);
+  fprintf(fp, "cmd: %s\n", gsb_last_file);
+  fprintf(fp, "positions: line\n");
+  fprintf(fp, "events: Commands Usec\n");
+  fprintf(fp, "summary: %llu %llu\n\n",
+          (unsigned long long)profile.funcs[PROFILE_MAIN].total_commands,
+          (unsigned long long)profile.funcs[PROFILE_MAIN].total_usec);
+  fprintf(fp, "fl=%s\n", gsb_last_file);
+
+  for (int f = 0; f < profile.func_count; f++) {
+    int header = 0;
+    for (int i = 0; i < profile.cost_size; i++) {
+      profile_cost_t *cost = &profile.costs[i];
+      if (cost->func != f) {
+        continue;
+      }
+      if (!header) {
+        fprintf(fp, "\nfn=%s\n", profile.funcs[f].name);
+        header = 1;
+      }
+      if (cost->callee != -1) {
+        fprintf(fp, "cfn=%s\n", profile.funcs[cost->callee].name);
+        fprintf(fp, "calls=%u %d\n", cost->calls, profile.funcs[cost->callee].line);
+      }
+      fprintf(fp, "%d %llu %llu\n", cost->line,
+              (unsigned long long)cost->commands, (unsigned long long)cost->usec);
+    }
+  }
+  fclose(fp);
+  return 1;
+}
+
+static int profile_cmp_func(const void *a, const void *b) {
+  const profile_func_t *fa = *(const profile_func_t **)a;
+  const profile_func_t *fb = *(const profile_func_t **)b;
+  if (fa->self_usec != fb->self_usec) {
+    return fa->self_usec < fb->self_usec ? 1 : -1;
+  }
+  return fa->self_commands < fb->self_commands ? 1 : fa->self_commands > fb->self_commands ? -1 : 0;
+}
+
+static int profile_cmp_cost(const void *a, const void *b) {
+  const profile_cost_t *ca = *(const profile_cost_t **)a;
+  const profile_cost_t *cb = *(const profile_cost_t **)b;
+  if (ca->usec != cb->usec) {
+    return ca->usec < cb->usec ? 1 : -1;
+  }
+  return ca->commands < cb->commands ? 1 : ca->commands > cb->commands ? -1 : 0;
+}
+
+void profile_print(FILE *output) {
+  if (!profile.func_count) {
+    return;
+  }
+  const profile_func_t *top = &profile.funcs[PROFILE_MAIN];
+  double total = top->total_usec ? top->total_usec : 1;
+
+  fprintf(output, "\nFlat profile: %llu commands, %.6f seconds\n\n",
+          (unsigned long long)top->total_commands, top->total_usec / 1e6);
+  fprintf(output, "%7s %12s %12s %12s %10s  %s\n",
+          "%time", "self-usec", "total-usec", "commands", "calls", "name");
+
+  const profile_func_t **funcs = malloc(profile.func_count * sizeof(profile_func_t *));
+  int count = 0;
+  for (int i = 0; i < profile.func_count; i++) {
+    if (profile.funcs[i].calls) {
+      funcs[count++] = &profile.funcs[i];
+    }
+  }
+  qsort(funcs, count, sizeof(profile_func_t *), profile_cmp_func);
+  for (int i = 0; i < count; i++) {
+    const profile_func_t *func = funcs[i];
+    fprintf(output, "%6.2f%% %12llu %12llu %12llu %10u  %s\n",
+            100.0 * func->self_usec / total,
+            (unsigned long long)func->self_usec,
+            (unsigned long long)func->total_usec,
+            (unsigned long long)func->self_commands,
+            func->calls, func->name);
+  }
+  free(funcs);
+
+  const profile_cost_t **costs = malloc(profile.cost_count * sizeof(profile_cost_t *));
+  count = 0;
+  for (int i = 0; i < profile.cost_size; i++) {
+    const profile_cost_t *cost = &profile.costs[i];
+    if (cost->func != -1 && cost->callee == -1 &&
+        (cost->func == PROFILE_MAIN || profile.funcs[cost->func].ip != INVALID_ADDR)) {
+      costs[count++] = cost;
+    }
+  }
+  qsort(costs, count, sizeof(profile_cost_t *), profile_cmp_cost);
+  fprintf(output, "\n%7s %12s %12s  %s\n", "%time", "self-usec", "commands", "line");
+  for (int i = 0; i < count && i < PROFILE_TOP_LINES; i++) {
+    const profile_cost_t *cost = costs[i];
+    fprintf(output, "%6.2f%% %12llu %12llu  %d (%s)\n",
+            100.0 * cost->usec / total,
+            (unsigned long long)cost->usec,
+            (unsigned long long)cost->commands,
+            cost->line, profile.funcs[cost->func].name);
+  }
+  free(costs);
+
+  fprintf(output, "\nVariables: %u at most in use, %llu reused, %llu new, %u chunks\n",
+          v_pool_stats.high_water,
+          (unsigned long long)v_pool_stats.hits,
+          (unsigned long long)v_pool_stats.misses,
+          v_pool_stats.chunks);
+}
+
+void profile_free() {
+  for (int i = 0; i < profile.func_count; i++) {
+    free(profile.funcs[i].name);
+  }
+  free(profile.funcs);
+  free(profile.costs);
+  free(profile.stack);
+  free(profile.builtins);
+  memset(&profile, 0, sizeof(profile));
+}
@@ -0,0 +1,108 @@
+// This file is part of SmallBASIC
+//
+// Profiler: commands and time per source line, SUB/FUNC and built-in
+//
+// This program is distributed under the terms of the GPL v2.0 or later
+// Download the GNU Public License (GPL) from www.gnu.org
+//
+// Copyright(C) 2026 The SmallBASIC authors.
+
+#if !defined(__sb_profile_h)
+#define __sb_profile_h
+
+#include "common/sys.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @ingroup exec
+ *
+ * the number of commands executed while profiling
+ */
+extern uint64_t profile_commands;
+
+/**
+ * @ingroup exec
+ *
+ * registers the name of a SUB or FUNC starting at ip (called by the compiler)
+ */
+void profile_add_udp(const char *name, bcip_t ip, int line);
+
+/**
+ * @ingroup exec
+ *
+ * starts profiling the task
+ */
+void profile_begin(int tid);
+
+/**
+ * @ingroup exec
+ *
+ * stops profiling and closes any open calls
+ */
+void profile_end(void);
+
+/**
+ * @ingroup exec
+ *
+ * the program has moved to a new source line
+ */
+void profile_line(int line);
+
+/**
+ * @ingroup exec
+ *
+ * a SUB or FUNC at ip has been called
+ */
+void profile_enter(bcip_t ip);
+
+/**
+ * @ingroup exec
+ *
+ * a SUB or FUNC has popped its call node
+ */
+void profile_leave(void);
+
+/**
+ * @ingroup exec
+ *
+ * a built-in function or procedure is called
+ */
+void profile_enter_builtin(bid_t code);
+
+/**
+ * @ingroup exec
+ *
+ * a built-in function or procedure has returned
+ */
+void profile_leave_builtin(void);
+
+/**
+ * @ingroup exec
+ *
+ * writes the call-graph and line costs in callgrind format
+ *
+ * @return non-zero on success
+ */
+int profile_write(const char *file_name);
+
+/**
+ * @ingroup exec
+ *
+ * prints the flat profile
+ */
+void profile_print(FILE *output);
+
+/**
+ * @ingroup exec
+ *
+ * releases the profile data
+ */
+void profile_free(void);
+
+#if defined(__cplusplus)
+}
+#endif
+#endif
@@ -23,6 +23,8 @@ extern "C" {
 #endif
 
 int sbasic_main(const char *file);
+int sbasic_main_bc(const char *file, const byte *bytecode);
+byte *sbasic_main_compile(const char *file, int *depends);
 
 #if defined(__cplusplus)
 }
@@ -17,6 +17,7 @@
 #include "common/units.h"
 #include "common/extlib.h"
 #include "common/messages.h"
+#include "common/profile.h"
 #include "languages/keywords.en.c"
 
 char *comp_array_uds_field(char *p, bc_t *bc);
@@ -58,6 +59,7 @@ extern void expr_parser(bc_t *bc);
 
 #define GROWSIZE 128
 #define MAX_PARAMS 256
+#define INDEX_SIZE 256
 
 typedef struct  {
   byte *code;
@@ -266,22 +268,128 @@ char *comp_prepare_name(char *dest, const char *source, int size) {
   return dest;
 }
 
+// indexes over the keyword tables, built on first use
+static comp_index_t keyword_index;
+static comp_index_t func_index;
+static comp_index_t proc_index;
+
+/*
+ * returns the hash of the name, names differing only in case have the same hash
+ */
+static inline uint32_t comp_index_hash(const char *name) {
+  uint32_t hash = 2166136261u;
+  for (; *name; name++) {
+    hash ^= (uint8_t)to_upper(*name);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/*
+ * adds the name to the index, the name must remain valid while the index is in use
+ */
+static void comp_index_add(comp_index_t *index, const char *name, bid_t id) {
+  if ((index->count + 1) * 2 > index->mask) {
+    // grow to keep the table at most half full
+    uint32_t size = index->slots ? (index->mask + 1) * 2 : INDEX_SIZE;
+    comp_index_slot_t *slots = (comp_index_slot_t *)calloc(size, sizeof(comp_index_slot_t));
+    for (uint32_t i = 0; index->slots && i <= index->mask; i++) {
+      if (index->slots[i].name) {
+        uint32_t j = index->slots[i].hash & (size - 1);
+        while (slots[j].name) {
+          j = (j + 1) & (size - 1);
+        }
+        slots[j] = index->slots[i];
+      }
+    }
+    free(index->slots);
+    index->slots = slots;
+    index->mask = size - 1;
+  }
+  uint32_t hash = comp_index_hash(name);
+  uint32_t i = hash & index->mask;
+  while (index->slots[i].name) {
+    i = (i + 1) & index->mask;
+  }
+  index->slots[i].name = name;
+  index->slots[i].hash = hash;
+  index->slots[i].id = id;
+  index->count++;
+}
+
+/*
+ * returns the ID of the name or -1 when not found
+ */
+static bid_t comp_index_get(comp_index_t *index, const char *name) {
+  if (index->slots) {
+    uint32_t hash = comp_index_hash(name);
+    uint32_t i = hash & index->mask;
+    while (index->slots[i].name) {
+      if (index->slots[i].hash == hash && strcmp(index->slots[i].name, name) == 0) {
+        return index->slots[i].id;
+      }
+      i = (i + 1) & index->mask;
+    }
+  }
+  return -1;
+}
+
+/*
+ * returns the lowest ID of the name ignoring case, or -1 when not found
+ */
+static bid_t comp_index_get_nocase(comp_index_t *index, const char *name) {
+  bid_t result = -1;
+  if (index->slots) {
+    uint32_t hash = comp_index_hash(name);
+    uint32_t i = hash & index->mask;
+    while (index->slots[i].name) {
+      if (index->slots[i].hash == hash && strcasecmp(index->slots[i].name, name) == 0 &&
+          (result == -1 || index->slots[i].id < result)) {
+        result = index->slots[i].id;
+      }
+      i = (i + 1) & index->mask;
+    }
+  }
+  return result;
+}
+
+static void comp_index_free(comp_index_t *index) {
+  free(index->slots);
+  memset(index, 0, sizeof(comp_index_t));
+}
+
+/*
+ * builds the indexes over the keyword tables, the first entry of a name is used
+ */
+static void comp_keyword_index_init() {
+  if (!keyword_index.slots) {
+    for (bid_t i = 0; keyword_table[i].name[0] != '\0'; i++) {
+      if (comp_index_get(&keyword_index, keyword_table[i].name) == -1) {
+        comp_index_add(&keyword_index, keyword_table[i].name, i);
+      }
+    }
+    for (bid_t i = 0; func_table[i].name[0] != '\0'; i++) {
+      if (comp_index_get(&func_index, func_table[i].name) == -1) {
+        comp_index_add(&func_index, func_table[i].name, i);
+      }
+    }
+    for (bid_t i = 0; proc_table[i].name[0] != '\0'; i++) {
+      if (comp_index_get(&proc_index, proc_table[i].name) == -1) {
+        comp_index_add(&proc_index, proc_table[i].name, i);
+      }
+    }
+  }
+}
+
 /*
  * returns the ID of the label. If there is no one, then it creates one
  */
 bid_t comp_label_getID(const char *label_name) {
-  bid_t idx = -1, i;
   char name[SB_KEYWORD_SIZE + 1];
 
   comp_prepare_name(name, label_name, SB_KEYWORD_SIZE);
 
-  for (i = 0; i < comp_labtable.count; i++) {
-    if (strcmp(comp_labtable.elem[i]->name, name) == 0) {
-      idx = i;
-      break;
-    }
-  }
-
+  bid_t idx = comp_index_get(&comp_labindex, name);
   if (idx == -1) {
     if (opt_verbose) {
       log_printf(MSG_NEW_LABEL, comp_line, name, comp_labcount);
@@ -303,6 +411,7 @@ bid_t comp_label_getID(const char *label_name) {
     comp_labtable.elem[comp_labtable.count] = label;
     idx = comp_labtable.count;
     comp_labtable.count++;
+    comp_index_add(&comp_labindex, label->name, idx);
   }
 
   return idx;
@@ -312,6 +421,7 @@ bid_t comp_label_getID(const char *label_name) {
  * set LABEL's position (IP)
  */
 void comp_label_setip(bid_t idx) {
+  comp_line_ip = INVALID_ADDR;
   if (idx < comp_labtable.count) {
     comp_labtable.elem[idx]->ip = comp_prog.count;
     comp_labtable.elem[idx]->dp = comp_data.count;
@@ -361,11 +471,10 @@ bid_t comp_udp_id(const char *proc_name, int scan_tree) {
         strcpy(name, base);
       }
       // search on local
-      for (i = 0; i < comp_udpcount; i++) {
-        if (strcmp(comp_udptable[i].name, name) == 0) {
-          free(root);
-          return i;
-        }
+      i = comp_index_get(&comp_udpindex, name);
+      if (i != -1) {
+        free(root);
+        return i;
       }
     } while (len);
 
@@ -375,10 +484,9 @@ bid_t comp_udp_id(const char *proc_name, int scan_tree) {
     comp_prepare_udp_name(name, proc_name);
 
     // search on local
-    for (i = 0; i < comp_udpcount; i++) {
-      if (strcmp(comp_udptable[i].name, name) == 0) {
-        return i;
-      }
+    i = comp_index_get(&comp_udpindex, name);
+    if (i != -1) {
+      return i;
     }
   }
 
@@ -391,7 +499,6 @@ bid_t comp_udp_id(const char *proc_name, int scan_tree) {
  */
 bid_t comp_add_udp(const char *proc_name) {
   char *name = comp_bc_temp;
-  bid_t idx = -1, i;
   comp_prepare_udp_name(name, proc_name);
 
   /*
@@ -402,13 +509,7 @@ bid_t comp_add_udp(const char *proc_name) {
    */
 
   // search
-  for (i = 0; i < comp_udpcount; i++) {
-    if (strcmp(comp_udptable[i].name, name) == 0) {
-      idx = i;
-      break;
-    }
-  }
-
+  bid_t idx = comp_index_get(&comp_udpindex, name);
   if (idx == -1) {
     if (comp_udpcount >= comp_udpsize) {
       comp_udpsize += GROWSIZE;
@@ -429,6 +530,7 @@ bid_t comp_add_udp(const char *proc_name) {
       strcpy(comp_udptable[comp_udpcount].name, name);
       idx = comp_udpcount;
       comp_udpcount++;
+      comp_index_add(&comp_udpindex, comp_udptable[idx].name, idx);
     }
   }
 
@@ -443,12 +545,17 @@ bid_t comp_udp_setip(const char *proc_name, bcip_t ip) {
   char *name = comp_bc_temp;
 
   comp_prepare_udp_name(name, proc_name);
+  comp_line_ip = INVALID_ADDR;
 
   idx = comp_udp_id(name, 0);
   if (idx != -1) {
     comp_udptable[idx].ip = comp_prog.count;
     comp_udptable[idx].level = comp_block_level;
     comp_udptable[idx].block_id = comp_block_id;
+    if (opt_profile && !comp_unit_flag) {
+      // callers jump past the procedure header
+      profile_add_udp(comp_udptable[idx].name, comp_prog.count + (ADDRSZ + 3), comp_line);
+    }
   }
   return idx;
 }
@@ -619,6 +726,7 @@ int comp_create_var(const char *name) {
     comp_vartable[comp_varcount].local_proc_level = 0;
     idx = comp_varcount;
     comp_varcount++;
+    comp_index_add(&comp_varindex, comp_vartable[idx].name, idx);
   }
   return idx;
 }
@@ -650,7 +758,7 @@ int comp_add_external_var(const char *name, int lib_id) {
  * the new variable created at local space otherwise at globale space
  */
 bid_t comp_var_getID(const char *var_name) {
-  bid_t idx = -1, i;
+  bid_t idx = -1;
   char tmp[SB_KEYWORD_SIZE + 1];
   char *name = comp_bc_temp;
 
@@ -670,10 +778,9 @@ bid_t comp_var_getID(const char *var_name) {
   // If the name is not found in comp_libtable then it
   // is treated as a structure reference
   if (dot != NULL && comp_check_lib(tmp)) {
-    for (i = 0; i < comp_varcount; i++) {
-      if (strcasecmp(comp_vartable[i].name, tmp) == 0) {
-        return i;
-      }
+    idx = comp_index_get_nocase(&comp_varindex, tmp);
+    if (idx != -1) {
+      return idx;
     }
 
     sc_raise(MSG_MEMBER_DOES_NOT_EXIST, tmp);
@@ -687,24 +794,16 @@ bid_t comp_var_getID(const char *var_name) {
   //
   strcpy(name, tmp);
 
-  for (i = 0; i < comp_varcount; i++) {
-    if (strcmp(comp_vartable[i].name, name) == 0) {
-      idx = i;
-      break;
-    }
-
-    if (comp_vartable[i].dolar_sup) {
-      // system variables must be visible with or without '$' suffix
-      char *dollar_name = malloc(strlen(comp_vartable[i].name) + 2);
-      strcpy(dollar_name, comp_vartable[i].name);
-      strcat(dollar_name, "$");
-      if (strcmp(dollar_name, name) == 0) {
-        idx = i;
-        free(dollar_name);
-        break;
-      }
-      free(dollar_name);
+  idx = comp_index_get(&comp_varindex, name);
+  int len = strlen(name);
+  if (idx == -1 && len > 1 && name[len - 1] == '$') {
+    // system variables must be visible with or without '$' suffix
+    name[len - 1] = '\0';
+    bid_t sys_idx = comp_index_get(&comp_varindex, name);
+    if (sys_idx != -1 && comp_vartable[sys_idx].dolar_sup) {
+      idx = sys_idx;
     }
+    name[len - 1] = '$';
   }
 
   if (opt_autolocal) {
@@ -801,6 +900,7 @@ void comp_add_variable(bc_t *bc, const char *var_name) {
  */
 void comp_push(bcip_t ip) {
   comp_pass_node_t *node = (comp_pass_node_t *)malloc(sizeof(comp_pass_node_t));
+  comp_line_ip = INVALID_ADDR;
   memset(node, 0, sizeof(comp_pass_node_t));
 
   strlcpy(node->sec, comp_bc_sec, sizeof(node->sec));
@@ -838,10 +938,9 @@ int comp_is_keyword(const char *name) {
     dolar_sup++;
   }
 
-  for (i = 0; keyword_table[i].name[0] != '\0'; i++) {
-    if (strcmp(keyword_table[i].name, name) == 0) {
-      return keyword_table[i].code;
-    }
+  i = comp_index_get(&keyword_index, name);
+  if (i != -1) {
+    return keyword_table[i].code;
   }
 
   if (dolar_sup) {
@@ -870,10 +969,9 @@ bid_t comp_is_func(const char *name) {
     dolar_sup++;
   }
 
-  for (i = 0; func_table[i].name[0] != '\0'; i++) {
-    if (strcmp(func_table[i].name, name) == 0) {
-      return func_table[i].fcode;
-    }
+  i = comp_index_get(&func_index, name);
+  if (i != -1) {
+    return func_table[i].fcode;
   }
 
   if (dolar_sup) {
@@ -889,10 +987,9 @@ bid_t comp_is_func(const char *name) {
 bid_t comp_is_proc(const char *name) {
   bid_t i;
 
-  for (i = 0; proc_table[i].name[0] != '\0'; i++) {
-    if (strcmp(proc_table[i].name, name) == 0) {
-      return proc_table[i].pcode;
-    }
+  i = comp_index_get(&proc_index, name);
+  if (i != -1) {
+    return proc_table[i].pcode;
   }
 
   return -1;
@@ -2862,9 +2959,14 @@ void comp_text_line(char *text, int addLineNo) {
     return;
   }
   if (addLineNo) {
+    if (!opt_trace_on && comp_line_ip == comp_prog.count) {
+      // replace the previous line marker when no code or jump target follows
+      comp_prog.count -= 1 + sizeof(bcip_t);
+    }
     // add debug info: line-number
     bc_add_code(&comp_prog, kwTYPE_LINE);
     bc_add_addr(&comp_prog, comp_line);
+    comp_line_ip = comp_prog.count;
   }
   if (idx == -1) {
     idx = comp_is_proc(comp_bc_name);
@@ -3708,6 +3810,130 @@ bcip_t comp_optimise_let(bcip_t ip, byte kw_opr, char sep, byte opt_kw) {
   return ip;
 }
 
+// append to the left side in place for a = a + expr [+ expr]..., where
+// each expr binds tighter than '+', does not refer to the left side and
+// does not call any user functions, with at most LET_APPEND_TERMS exprs.
+// the kwTYPE_EVPOP before each '+' is replaced with kwTYPE_EOC to end the
+// evaluation of each expr
+bcip_t comp_optimise_append(bcip_t ip) {
+  const bcip_t var_len = 1 + sizeof(bcip_t);
+  byte *bc = comp_prog.ptr;
+  bcip_t ip_var = ip + 1;
+  if (bc[ip_var] != kwTYPE_VAR ||
+      bc[ip_var + var_len] != kwTYPE_CMPOPR ||
+      bc[ip_var + var_len + 1] != '=' ||
+      bc[ip_var + var_len + 2] != kwTYPE_VAR ||
+      memcmp(bc + ip_var + 1, bc + ip_var + var_len + 3, sizeof(bcip_t)) != 0 ||
+      (bc[ip_var + var_len * 2 + 2] != kwTYPE_EVPUSH &&
+       bc[ip_var + var_len * 2 + 2] != kwTYPE_EVOPR)) {
+    return ip;
+  }
+
+  // verify the expression before making any changes
+  int depth = 1;
+  int terms = 1;
+  bcip_t ip_next = ip_var + var_len * 2 + 3;
+  while (ip_next < comp_prog.count && bc[ip_next] != kwTYPE_EOC) {
+    switch (bc[ip_next]) {
+    case kwTYPE_EVPUSH:
+    case kwTYPE_EVOPR:
+      depth++;
+      break;
+    case kwTYPE_EVPOP:
+      if (--depth == 0) {
+        if (bc[ip_next + 1] != kwTYPE_ADDOPR || bc[ip_next + 2] != '+') {
+          return ip;
+        }
+        if (bc[ip_next + 3] != kwTYPE_EOC && bc[ip_next + 3] != kwTYPE_EVPUSH &&
+            bc[ip_next + 3] != kwTYPE_EVOPR) {
+          return ip;
+        }
+      }
+      break;
+    case kwTYPE_VAR:
+      if (memcmp(bc + ip_var + 1, bc + ip_next + 1, sizeof(bcip_t)) == 0) {
+        return ip;
+      }
+      break;
+    case kwTYPE_CALL_UDF:
+    case kwTYPE_CALL_PTR:
+    case kwTYPE_CALLEXTF:
+    case kwUSE:
+      return ip;
+    default:
+      break;
+    }
+    if (depth == 0 && bc[ip_next] == kwTYPE_ADDOPR &&
+        (bc[ip_next + 2] == kwTYPE_EVPUSH || bc[ip_next + 2] == kwTYPE_EVOPR)) {
+      // the next expr starts after the following kwTYPE_EVPUSH
+      if (++terms > LET_APPEND_TERMS) {
+        return ip;
+      }
+      depth = 1;
+      ip_next += 3;
+    } else {
+      ip_next = comp_next_bc_cmd(&comp_prog, ip_next);
+    }
+  }
+  if (depth != 0) {
+    return ip;
+  }
+
+  bc[ip] = kwLET_APPEND;
+  depth = 1;
+  ip_next = ip_var + var_len * 2 + 3;
+  while (bc[ip_next] != kwTYPE_EOC) {
+    if (bc[ip_next] == kwTYPE_EVPUSH || bc[ip_next] == kwTYPE_EVOPR) {
+      depth++;
+    } else if (bc[ip_next] == kwTYPE_EVPOP && --depth == 0) {
+      bc[ip_next] = kwTYPE_EOC;
+      depth = 1;
+      ip_next += 3;
+      if (bc[ip_next] == kwTYPE_EOC) {
+        break;
+      }
+    }
+    ip_next = comp_next_bc_cmd(&comp_prog, ip_next);
+  }
+  return ip_next;
+}
+
+// a = a + n or a = a - n, where n is a number, updates the left side in
+// place when it holds a number, see cmd_let_inc()
+bcip_t comp_optimise_inc(bcip_t ip) {
+  const bcip_t var_len = 1 + sizeof(bcip_t);
+  byte *bc = comp_prog.ptr;
+  bcip_t ip_var = ip + 1;
+  bcip_t ip_num = ip_var + var_len * 2 + 3;
+  bcip_t ip_opr;
+  if (bc[ip_var] != kwTYPE_VAR ||
+      bc[ip_var + var_len] != kwTYPE_CMPOPR ||
+      bc[ip_var + var_len + 1] != '=' ||
+      bc[ip_var + var_len + 2] != kwTYPE_VAR ||
+      memcmp(bc + ip_var + 1, bc + ip_var + var_len + 3, sizeof(bcip_t)) != 0 ||
+      bc[ip_num - 1] != kwTYPE_EVOPR) {
+    return ip;
+  }
+  switch (bc[ip_num]) {
+  case kwTYPE_INT:
+    ip_opr = ip_num + 1 + OS_INTSZ;
+    break;
+  case kwTYPE_NUM:
+    ip_opr = ip_num + 1 + OS_REALSZ;
+    break;
+  default:
+    return ip;
+  }
+  if (bc[ip_opr] == kwTYPE_EVPOP &&
+      bc[ip_opr + 1] == kwTYPE_ADDOPR &&
+      (bc[ip_opr + 2] == '+' || bc[ip_opr + 2] == '-') &&
+      bc[ip_opr + 3] == kwTYPE_EOC) {
+    bc[ip] = kwLET_INC;
+    ip = ip_opr + 3;
+  }
+  return ip;
+}
+
 void comp_optimise() {
   for (bcip_t ip = 0; !comp_error && ip < comp_prog.count;
        ip = comp_next_bc_cmd(&comp_prog, ip)) {
@@ -3719,6 +3945,12 @@ void comp_optimise() {
       break;
     case kwLET:
       ip = comp_optimise_let(ip, kwTYPE_CMPOPR, '=', kwLET_OPT);
+      if (comp_prog.ptr[ip] == kwLET) {
+        ip = comp_optimise_inc(ip);
+      }
+      if (comp_prog.ptr[ip] == kwLET) {
+        ip = comp_optimise_append(ip);
+      }
       break;
     case kwAPPEND:
       ip = comp_optimise_let(ip, kwTYPE_SEP, ',', kwAPPEND_OPT);
@@ -3742,6 +3974,7 @@ void comp_init() {
   comp_bc_proc = malloc(SB_SOURCELINE_SIZE + 1);
 
   comp_line = 0;
+  comp_line_ip = INVALID_ADDR;
   comp_error = 0;
   comp_labcount = 0;
   comp_expcount = 0;
@@ -3753,6 +3986,7 @@ void comp_init() {
   comp_block_level = 0;
   comp_block_id = 0;
   comp_unit_flag = 0;
+  comp_include_count = 0;
   comp_first_data_ip = INVALID_ADDR;
   comp_proc_level = 0;
   comp_bc_proc[0] = '\0';
@@ -3764,6 +3998,11 @@ void comp_init() {
   comp_labtable.size = 256;
   comp_labtable.elem = (comp_label_t **)malloc(comp_labtable.size * sizeof(comp_label_t *));
 
+  memset(&comp_varindex, 0, sizeof(comp_index_t));
+  memset(&comp_udpindex, 0, sizeof(comp_index_t));
+  memset(&comp_labindex, 0, sizeof(comp_index_t));
+  comp_keyword_index_init();
+
   comp_stack.count = 0;
   comp_stack.size = 256;
   comp_stack.elem = (comp_pass_node_t **)malloc(comp_stack.size * sizeof(comp_pass_node_t *));
@@ -3824,6 +4063,10 @@ void comp_close() {
   }
   free(comp_labtable.elem);
 
+  comp_index_free(&comp_varindex);
+  comp_index_free(&comp_udpindex);
+  comp_index_free(&comp_labindex);
+
   for (i = 0; i < comp_exptable.count; i++) {
     free(comp_exptable.elem[i]);
   }
@@ -4353,6 +4596,7 @@ void comp_preproc_include(char *p) {
     strlcpy(oldFileName, comp_file_name, sizeof(oldFileName));
     char *source = comp_load(path);
     if (source) {
+      comp_include_count++;
       comp_pass1(NULL, source);
       free(source);
     }
@@ -4951,11 +5195,13 @@ int comp_compile(const char *sb_file_name) {
   }
 
   int is_unit = comp_unit_flag;
+  int depends = comp_include_count || comp_libcount;
   int error = comp_error;
   comp_close();
   close_task(tid);
   activate_task(prev_tid);
   ctask->bc_type = is_unit ? 2 : 1;
+  ctask->bc_depends = depends;
   ctask->error = error;
 
   if (opt_nosave && !is_unit) {
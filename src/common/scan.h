@@ -158,6 +158,24 @@ struct comp_proc_s {
 
 typedef struct comp_proc_s comp_udp_t;
 
+/**
+ * @ingroup scan
+ * @typedef comp_index_t
+ *
+ * hash index over the names of a compiler table
+ */
+typedef struct {
+  const char *name; /**< the name, owned by the table entry */
+  uint32_t hash; /**< hash of the name */
+  bid_t id; /**< table position */
+} comp_index_slot_t;
+
+typedef struct {
+  comp_index_slot_t *slots;
+  uint32_t count;
+  uint32_t mask;
+} comp_index_t;
+
 /*
  * @ingroup scan
  * @typedef comp_pass_node_t
@@ -118,6 +118,7 @@ EXTERN byte opt_mute_audio; /**< whether to mute sounds                      */
 EXTERN byte opt_antialias; /**< OPTION ANTIALIAS OFF                         */
 EXTERN byte opt_autolocal; /**< OPTION AUTOLOCAL                             */
 EXTERN byte opt_trace_on; /**< initial value for the TRON command            */
+EXTERN byte opt_profile; /**< collect a profile while running                */
 
 #define IDE_NONE        0
 #define IDE_INTERNAL    1
@@ -150,6 +151,7 @@ EXTERN char gsb_last_errmsg[SB_ERRMSG_SIZE + 1]; /**< last error message     */
 #define prog_stack          ctask->sbe.exec.stack
 #define prog_stack_alloc    ctask->sbe.exec.stack_alloc
 #define prog_sp             ctask->sbe.exec.sp
+#define prog_frame          ctask->sbe.exec.frame
 #define eval_stk            ctask->sbe.exec.eval_stk
 #define eval_stk_size       ctask->sbe.exec.eval_stk_size
 #define eval_sp             ctask->sbe.exec.eval_esp
@@ -173,6 +175,7 @@ EXTERN char gsb_last_errmsg[SB_ERRMSG_SIZE + 1]; /**< last error message     */
 #define comp_vartable       ctask->sbe.comp.vartable
 #define comp_varcount       ctask->sbe.comp.varcount
 #define comp_varsize        ctask->sbe.comp.varsize
+#define comp_varindex       ctask->sbe.comp.varindex
 #define comp_imptable       ctask->sbe.comp.imptable
 #define comp_impcount       ctask->sbe.comp.imptable.count
 #define comp_exptable       ctask->sbe.comp.exptable
@@ -181,10 +184,12 @@ EXTERN char gsb_last_errmsg[SB_ERRMSG_SIZE + 1]; /**< last error message     */
 #define comp_libcount       ctask->sbe.comp.libtable.count
 #define comp_labtable       ctask->sbe.comp.labtable
 #define comp_labcount       ctask->sbe.comp.labtable.count
+#define comp_labindex       ctask->sbe.comp.labindex
 #define comp_bc_sec         ctask->sbe.comp.bc_sec
 #define comp_block_level    ctask->sbe.comp.block_level
 #define comp_block_id       ctask->sbe.comp.block_id
 #define comp_prog           ctask->sbe.comp.bc_prog
+#define comp_line_ip        ctask->sbe.comp.line_ip
 #define comp_data           ctask->sbe.comp.bc_data
 #define comp_proc_level     ctask->sbe.comp.proc_level
 #define comp_bc_proc        ctask->sbe.comp.bc_proc
@@ -195,6 +200,7 @@ EXTERN char gsb_last_errmsg[SB_ERRMSG_SIZE + 1]; /**< last error message     */
 #define comp_udptable       ctask->sbe.comp.udptable
 #define comp_udpcount       ctask->sbe.comp.udpcount
 #define comp_udpsize        ctask->sbe.comp.udpsize
+#define comp_udpindex       ctask->sbe.comp.udpindex
 #define comp_next_field_id  ctask->sbe.comp.next_field_id
 #define comp_use_global_vartable    ctask->sbe.comp.use_global_vartable
 #define comp_stack          ctask->sbe.comp.stack
@@ -202,6 +208,7 @@ EXTERN char gsb_last_errmsg[SB_ERRMSG_SIZE + 1]; /**< last error message     */
 #define comp_do_close_cmd   ctask->sbe.comp.do_close_cmd
 #define comp_unit_flag      ctask->sbe.comp.unit_flag
 #define comp_unit_name      ctask->sbe.comp.unit_name
+#define comp_include_count  ctask->sbe.comp.include_count
 #define comp_first_data_ip  ctask->sbe.comp.first_data_ip
 #define comp_file_name      ctask->sbe.comp.file_name
 #define tlab                prog_labtable
@@ -38,6 +38,7 @@ typedef struct {
   stknode_t *stack; /**< The program stack                           */
   uint32_t stack_alloc; /**< The stack size                          */
   uint32_t sp; /**< Register SP; The stack pointer                   */
+  frame_block_t *frame; /**< The frame arena block in use            */
   var_t *eval_stk; /**< eval's stack                                 */
   uint16_t eval_stk_size; /**< eval's stack size                     */
   uint16_t eval_esp; /**< Register ESP; eval's stack pointer          */
@@ -74,6 +75,7 @@ typedef struct {
   char file_name[OS_PATHNAME_SIZE + 1];
   char unit_name[SB_KEYWORD_SIZE + 1];
   int unit_flag;
+  int include_count; // number of INCLUDE files compiled
 
   bc_lib_rec_table_t libtable;
   bc_symbol_rec_table_t imptable;
@@ -83,6 +85,7 @@ typedef struct {
   int block_id;   // unique ID for blocks (FOR-NEXT,IF-FI,etc)
 
   bcip_t first_data_ip;
+  bcip_t line_ip; // code position after the last line marker
 
   // buffers... needed for devices with limited memory
   char *bc_name;
@@ -105,14 +108,17 @@ typedef struct {
   comp_var_t *vartable;
   bid_t varcount;
   bid_t varsize;
+  comp_index_t varindex;
 
   // label table
   comp_label_table_t labtable;
+  comp_index_t labindex;
 
   // user defined proc/func table
   comp_udp_t *udptable;
   bid_t udpcount;
   bid_t udpsize;
+  comp_index_t udpindex;
 
   // pass2 stack
   comp_pass_node_table_t stack;
@@ -136,6 +142,7 @@ typedef struct {
   char file[OS_PATHNAME_SIZE + 1];  /**< The program file name (task name) */
   byte *bytecode; /**< BC's memory handle                          */
   int bc_type; /**< BC type (1=executable, 2=unit)                 */
+  int bc_depends; /**< BC was compiled with INCLUDE or IMPORT files */
   int has_sysvars; /**< true if the task has system-variables      */
 
   // compiler/executor
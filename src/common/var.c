@@ -11,22 +11,79 @@
 #include "common/sberr.h"
 
 #define INT_STR_LEN 64
-#define VAR_POOL_SIZE 8192
+#define VAR_POOL_CHUNK 2048
 
-var_t var_pool[VAR_POOL_SIZE];
-var_t *var_pool_head;
+// the largest integer held exactly by var_num_t
+#define V_NUM_EXACT_INT ((var_int_t)1 << 53)
+
+typedef struct var_chunk_s {
+  struct var_chunk_s *next;
+  var_t vars[VAR_POOL_CHUNK];
+} var_chunk_t;
+
+// the pool grows in chunks, variables are handed out from var_chunk
+// once the free-list is empty
+static var_chunk_t *var_chunks;
+static var_chunk_t *var_chunk;
+static uint32_t var_chunk_next;
+static var_t *var_pool_head;
+
+// released array dimensions, linked through the bounds
+static var_dims_t *var_dims_head;
+var_pool_stats_t v_pool_stats;
+int v_share_lock;
+const void *v_indexed_data;
 
 void v_init_pool() {
-  for (uint32_t i = 0; i < VAR_POOL_SIZE; i++) {
-    v_init(&var_pool[i]);
-    var_pool[i].pooled = 1;
-    if (i + 1 < VAR_POOL_SIZE) {
-      var_pool[i].v.pool_next = &var_pool[i + 1];
-    } else {
-      var_pool[i].v.pool_next = NULL;
+  // reclaim the whole pool, the chunks are kept
+  var_chunk = var_chunks;
+  var_chunk_next = 0;
+  var_pool_head = NULL;
+  memset(&v_pool_stats, 0, sizeof(v_pool_stats));
+  for (var_chunk_t *chunk = var_chunks; chunk != NULL; chunk = chunk->next) {
+    v_pool_stats.chunks++;
+  }
+}
+
+void v_free_pool() {
+  while (var_chunks != NULL) {
+    var_chunk_t *next = var_chunks->next;
+    free(var_chunks);
+    var_chunks = next;
+  }
+  var_chunk = NULL;
+  var_chunk_next = 0;
+  var_pool_head = NULL;
+  while (var_dims_head != NULL) {
+    var_dims_t *next = *(var_dims_t **)var_dims_head;
+    free((char *)var_dims_head - V_REFS_SIZE);
+    var_dims_head = next;
+  }
+}
+
+/*
+ * returns the next unused variable, adding a chunk when required
+ */
+static var_t *v_pool_grow() {
+  if (var_chunk == NULL || var_chunk_next == VAR_POOL_CHUNK) {
+    var_chunk_t *next = var_chunk != NULL ? var_chunk->next : var_chunks;
+    if (next == NULL) {
+      next = (var_chunk_t *)malloc(sizeof(var_chunk_t));
+      next->next = NULL;
+      if (var_chunk != NULL) {
+        var_chunk->next = next;
+      } else {
+        var_chunks = next;
+      }
+      v_pool_stats.chunks++;
     }
+    var_chunk = next;
+    var_chunk_next = 0;
   }
-  var_pool_head = &var_pool[0];
+  var_t *result = &var_chunk->vars[var_chunk_next++];
+  result->pooled = 1;
+  v_pool_stats.misses++;
+  return result;
 }
 
 /*
@@ -37,10 +94,12 @@ var_t *v_new() {
   if (result != NULL) {
     // remove an item from the free-list
     var_pool_head = result->v.pool_next;
+    v_pool_stats.hits++;
   } else {
-    // pool exhausted
-    result = (var_t *)malloc(sizeof(var_t));
-    result->pooled = 0;
+    result = v_pool_grow();
+  }
+  if (++v_pool_stats.used > v_pool_stats.high_water) {
+    v_pool_stats.high_water = v_pool_stats.used;
   }
   v_init(result);
   return result;
@@ -50,6 +109,94 @@ void v_pool_free(var_t *var) {
   // insert back into the free list
   var->v.pool_next = var_pool_head;
   var_pool_head = var;
+  v_pool_stats.used--;
+}
+
+/*
+ * allocates a block with a reference count of one ahead of the data
+ */
+static void *v_block_alloc(size_t size) {
+  char *block = (char *)malloc(V_REFS_SIZE + size);
+  if (block == NULL) {
+    return NULL;
+  }
+  *(uint32_t *)block = 1;
+  return block + V_REFS_SIZE;
+}
+
+static void *v_block_calloc(size_t count, size_t size) {
+  char *block = (char *)calloc(1, V_REFS_SIZE + count * size);
+  if (block == NULL) {
+    return NULL;
+  }
+  *(uint32_t *)block = 1;
+  return block + V_REFS_SIZE;
+}
+
+// resize an unshared block
+static void *v_block_realloc(void *data, size_t size) {
+  if (data == v_indexed_data) {
+    v_indexed_data = NULL;
+  }
+  char *block = (char *)realloc((char *)data - V_REFS_SIZE, V_REFS_SIZE + size);
+  return block == NULL ? NULL : block + V_REFS_SIZE;
+}
+
+void v_block_free(void *data) {
+  uint32_t *refs = (uint32_t *)((char *)data - V_REFS_SIZE);
+  if (--(*refs) == 0) {
+    if (data == v_indexed_data) {
+      v_indexed_data = NULL;
+    }
+    free(refs);
+  }
+}
+
+#define v_dims_refs(x) (*(uint32_t *)((char *)(x)->v.a.dims - V_REFS_SIZE))
+
+// returns dimensions from the free-list or else a new block
+static var_dims_t *v_dims_alloc() {
+  var_dims_t *dims = var_dims_head;
+  if (dims != NULL) {
+    var_dims_head = *(var_dims_t **)dims;
+    *(uint32_t *)((char *)dims - V_REFS_SIZE) = 1;
+  } else {
+    dims = (var_dims_t *)v_block_alloc(sizeof(var_dims_t));
+  }
+  return dims;
+}
+
+// drop a reference, the last holder returns the dimensions to the free-list
+static void v_dims_release(var_dims_t *dims) {
+  uint32_t *refs = (uint32_t *)((char *)dims - V_REFS_SIZE);
+  if (--(*refs) == 0) {
+    *(var_dims_t **)dims = var_dims_head;
+    var_dims_head = dims;
+  }
+}
+
+// attach a one dimension header to the array
+static void v_dims_init(var_t *var) {
+  var_dims_t *dims = v_dims_alloc();
+  if (!dims) {
+    err_memory();
+    return;
+  }
+  dims->maxdim = 1;
+  dims->ubound[0] = opt_base;
+  dims->lbound[0] = opt_base;
+  var->v.a.dims = dims;
+}
+
+// attach a copy of the src dimensions to the array
+static void v_dims_copy(var_t *var, const var_dims_t *src) {
+  var_dims_t *dims = v_dims_alloc();
+  if (!dims) {
+    err_memory();
+    return;
+  }
+  memcpy(dims, src, sizeof(var_dims_t));
+  var->v.a.dims = dims;
 }
 
 uint32_t v_get_capacity(uint32_t size) {
@@ -61,76 +208,245 @@ void v_alloc_capacity(var_t *var, uint32_t size) {
   uint32_t capacity = v_get_capacity(size);
   v_capacity(var) = capacity;
   v_asize(var) = size;
-  v_data(var) = (var_t *)malloc(sizeof(var_t) * capacity);
+  v_packed(var) = V_PACKED_NONE;
+  v_data(var) = (var_t *)v_block_alloc(sizeof(var_t) * capacity);
   if (!v_data(var)) {
     err_memory();
   } else {
     for (uint32_t i = 0; i < capacity; i++) {
-      var_t *e = v_elem(var, i);
+      var_t *e = &v_data(var)[i];
       e->pooled = 0;
       v_init(e);
     }
   }
 }
 
+// allocate packed capacity in the array container
+void v_alloc_packed(var_t *var, uint32_t size) {
+  uint32_t capacity = v_get_capacity(size);
+  v_capacity(var) = capacity;
+  v_asize(var) = size;
+  v_packed(var) = V_PACKED_INT;
+  v_data(var) = (var_t *)v_block_calloc(capacity, sizeof(var_pack_t));
+  if (!v_data(var)) {
+    err_memory();
+  }
+}
+
 // create an new empty array
 void v_init_array(var_t *var) {
   v_capacity(var) = 0;
   v_asize(var) = 0;
+  v_packed(var) = V_PACKED_NONE;
   v_data(var) = NULL;
-  v_maxdim(var) = 1;
-  v_ubound(var, 0) = opt_base;
-  v_lbound(var, 0) = opt_base;
+  v_dims_init(var);
 }
 
 // create an array of the given size
 void v_new_array(var_t *var, uint32_t size) {
   var->type = V_ARRAY;
+  v_dims_init(var);
   v_alloc_capacity(var, size);
 }
 
+// create a packed numeric array of the given size
+void v_new_packed_array(var_t *var, uint32_t size) {
+  var->type = V_ARRAY;
+  v_dims_init(var);
+  v_alloc_packed(var, size);
+}
+
+// convert the packed elements into var_t elements, leaving any other
+// holder of the packed block untouched
+var_t *v_array_unpack(var_t *var) {
+  var_pack_t *packed = v_pdata(var);
+  uint32_t capacity = v_capacity(var);
+  var_t *data = (var_t *)v_block_alloc(sizeof(var_t) * capacity);
+  if (!data) {
+    err_memory();
+    return v_data(var);
+  }
+  for (uint32_t i = 0; i < capacity; i++) {
+    var_t *e = &data[i];
+    e->pooled = 0;
+    e->const_flag = 0;
+    if (v_packed(var) == V_PACKED_INT) {
+      e->type = V_INT;
+      e->v.i = packed[i].i;
+    } else {
+      e->type = V_NUM;
+      e->v.n = packed[i].n;
+    }
+  }
+  v_block_free(packed);
+  v_data(var) = data;
+  v_packed(var) = V_PACKED_NONE;
+  return data;
+}
+
+// give the array its own copy of the elements when they are shared
+void v_array_unshare(var_t *var) {
+  if (v_shared(var)) {
+    var_t *shared = v_data(var);
+    uint32_t size = v_asize(var);
+    uint32_t capacity = v_capacity(var);
+    if (v_packed(var)) {
+      var_pack_t *packed = (var_pack_t *)v_block_calloc(capacity, sizeof(var_pack_t));
+      if (!packed) {
+        err_memory();
+        return;
+      }
+      memcpy(packed, shared, sizeof(var_pack_t) * size);
+      v_data(var) = (var_t *)packed;
+    } else {
+      var_t *data = (var_t *)v_block_alloc(sizeof(var_t) * capacity);
+      if (!data) {
+        err_memory();
+        return;
+      }
+      for (uint32_t i = 0; i < capacity; i++) {
+        data[i].pooled = 0;
+        v_init(&data[i]);
+      }
+      for (uint32_t i = 0; i < size; i++) {
+        v_set(&data[i], &shared[i]);
+      }
+      v_data(var) = data;
+    }
+    v_block_free(shared);
+  }
+}
+
+// returns the elements for writing
+var_t *v_array_data(var_t *var) {
+  if (v_data(var) == v_indexed_data) {
+    v_indexed_data = NULL;
+  }
+  if (v_packed(var)) {
+    return v_array_unpack(var);
+  }
+  v_array_unshare(var);
+  return v_data(var);
+}
+
+// give the array its own copy of the dimensions when they are shared
+var_dims_t *v_array_dims(var_t *var) {
+  var_dims_t *dims = var->v.a.dims;
+  if (v_dims_refs(var) > 1) {
+    v_dims_copy(var, dims);
+    v_dims_release(dims);
+  }
+  return var->v.a.dims;
+}
+
+// store a numeric value in the packed element
+int v_packed_store(var_t *var, uint32_t index, const var_t *value) {
+  if (value->type != V_INT && value->type != V_NUM) {
+    return 0;
+  }
+  v_array_unshare(var);
+  var_pack_t *packed = v_pdata(var);
+  if (packed == v_indexed_data) {
+    v_indexed_data = NULL;
+  }
+  int result = 1;
+  if (value->type == V_INT) {
+    if (v_packed(var) == V_PACKED_INT) {
+      packed[index].i = value->v.i;
+    } else {
+      packed[index].n = value->v.i;
+    }
+  } else if (value->type == V_NUM) {
+    if (v_packed(var) == V_PACKED_INT) {
+      // widen the integer elements, unless one is beyond the 53 bit mantissa
+      uint32_t v_size = v_asize(var);
+      for (uint32_t i = 0; i < v_size; i++) {
+        var_int_t n = packed[i].i;
+        if (n > V_NUM_EXACT_INT || n < -V_NUM_EXACT_INT) {
+          return 0;
+        }
+      }
+      for (uint32_t i = 0; i < v_size; i++) {
+        packed[i].n = packed[i].i;
+      }
+      v_packed(var) = V_PACKED_NUM;
+    }
+    packed[index].n = value->v.n;
+  } else {
+    result = 0;
+  }
+  return result;
+}
+
+// assign the packed element to result
+void v_packed_get(const var_t *var, uint32_t index, var_t *result) {
+  if (v_packed(var) == V_PACKED_INT) {
+    result->type = V_INT;
+    result->v.i = v_pdata(var)[index].i;
+  } else {
+    result->type = V_NUM;
+    result->v.n = v_pdata(var)[index].n;
+  }
+}
+
 void v_set_array1_size(var_t *var, uint32_t size) {
+  var_dims_t *dims = v_array_dims(var);
   v_asize(var) = size;
-  v_maxdim(var) = 1;
-  v_ubound(var, 0) = v_lbound(var, 0) + (size - 1);
+  dims->maxdim = 1;
+  dims->ubound[0] = dims->lbound[0] + (size - 1);
 }
 
 void v_copy_array(var_t *dest, const var_t *src) {
   dest->type = V_ARRAY;
-  v_alloc_capacity(dest, v_asize(src));
+  if (v_packed(src)) {
+    v_alloc_packed(dest, v_asize(src));
+  } else {
+    v_alloc_capacity(dest, v_asize(src));
+  }
 
   // copy dimensions
-  v_maxdim(dest) = v_maxdim(src);
-  for (int i = 0; i < v_maxdim(src); i++) {
-    v_ubound(dest, i) = v_ubound(src, i);
-    v_lbound(dest, i) = v_lbound(src, i);
-  }
+  v_dims_copy(dest, src->v.a.dims);
 
-  // copy each element
-  uint32_t v_size = v_asize(src);
-  for (uint32_t i = 0; i < v_size; i++) {
-    var_t *dest_vp = v_elem(dest, i);
-    v_init(dest_vp);
-    v_set(dest_vp, v_elem(src, i));
+  if (v_packed(src)) {
+    // copy the packed elements
+    v_packed(dest) = v_packed(src);
+    memcpy(v_data(dest), v_data(src), sizeof(var_pack_t) * v_asize(src));
+  } else {
+    // copy each element
+    uint32_t v_size = v_asize(src);
+    for (uint32_t i = 0; i < v_size; i++) {
+      var_t *dest_vp = &v_data(dest)[i];
+      v_init(dest_vp);
+      v_set(dest_vp, &v_data(src)[i]);
+    }
   }
 }
 
 void v_array_free(var_t *var) {
-  uint32_t v_size = v_capacity(var);
-  if (v_size && v_data(var)) {
-    for (uint32_t i = 0; i < v_size; i++) {
-      v_free(v_elem(var, i));
+  var_t *data = v_data(var);
+  v_dims_release(var->v.a.dims);
+  if (data == NULL) {
+    // empty array
+  } else if (v_refs(var) > 1) {
+    // still held by another array
+    v_refs(var)--;
+  } else {
+    if (!v_packed(var)) {
+      uint32_t v_size = v_capacity(var);
+      for (uint32_t i = 0; i < v_size; i++) {
+        v_free(&data[i]);
+      }
     }
-    free(var->v.a.data);
+    v_block_free(data);
   }
 }
 
 void v_init_str(var_t *var, int length) {
   var->type = V_STR;
-  var->v.p.ptr = malloc(length + 1);
+  var->v.p.ptr = v_block_alloc(length + 1);
   var->v.p.ptr[0] = '\0';
   var->v.p.length = length + 1;
-  var->v.p.owner = 1;
+  var->v.p.owner = V_STR_COUNTED;
 }
 
 void v_move_str(var_t *var, char *str) {
@@ -206,6 +522,29 @@ int v_length(var_t *var) {
   return 0;
 }
 
+/*
+ * resize an existing packed array, new elements are zero
+ */
+void v_resize_packed(var_t *v, uint32_t size) {
+  v_array_unshare(v);
+  if (size > v_capacity(v)) {
+    uint32_t capacity = v_get_capacity(size);
+    var_pack_t *data = (var_pack_t *)v_block_realloc(v_data(v), sizeof(var_pack_t) * capacity);
+    if (!data) {
+      err_memory();
+      return;
+    }
+    memset(data + v_capacity(v), 0, sizeof(var_pack_t) * (capacity - v_capacity(v)));
+    v_data(v) = (var_t *)data;
+    v_capacity(v) = capacity;
+  }
+  uint32_t prev_size = v_asize(v);
+  if (size > prev_size) {
+    memset(v_pdata(v) + prev_size, 0, sizeof(var_pack_t) * (size - prev_size));
+  }
+  v_set_array1_size(v, size);
+}
+
 /*
  * resize an existing array
  */
@@ -220,15 +559,19 @@ void v_resize_array(var_t *v, uint32_t size) {
     v_free(v);
     v_init_array(v);
     v->type = V_ARRAY;
+  } else if (v_packed(v)) {
+    v_resize_packed(v, size);
   } else if (size < v_asize(v)) {
     // resize down. free discarded elements
+    v_array_unshare(v);
     uint32_t v_size = v_asize(v);
     for (uint32_t i = size; i < v_size; i++) {
-      v_free(v_elem(v, i));
+      v_free(&v_data(v)[i]);
     }
     v_set_array1_size(v, size);
   } else if (size <= v_capacity(v)) {
     // use existing capacity
+    v_array_unshare(v);
     v_set_array1_size(v, size);
   } else {
     // insufficient capacity
@@ -238,10 +581,11 @@ void v_resize_array(var_t *v, uint32_t size) {
     } else if (prev_size < size) {
       // resize & copy
       uint32_t capacity = v_get_capacity(size);
+      v_array_unshare(v);
       v_capacity(v) = capacity;
-      v_data(v) = (var_t *)realloc(v_data(v), sizeof(var_t) * capacity);
+      v_data(v) = (var_t *)v_block_realloc(v_data(v), sizeof(var_t) * capacity);
       for (uint32_t i = prev_size; i < capacity; i++) {
-        var_t *e = v_elem(v, i);
+        var_t *e = &v_data(v)[i];
         e->pooled = 0;
         v_init(e);
       }
@@ -249,7 +593,7 @@ void v_resize_array(var_t *v, uint32_t size) {
 
     // init vars
     for (uint32_t i = prev_size; i < size; i++) {
-      v_init(v_elem(v, i));
+      v_init(&v_data(v)[i]);
     }
 
     v_set_array1_size(v, size);
@@ -377,8 +721,9 @@ int v_compare(var_t *a, var_t *b) {
     }
     // check every element
     for (uint32_t i = 0; i < v_asize(a); i++) {
-      var_t *ea = v_elem(a, i);
-      var_t *eb = v_elem(b, i);
+      var_t tmp_a, tmp_b;
+      var_t *ea = v_elem_get(a, i, &tmp_a);
+      var_t *eb = v_elem_get(b, i, &tmp_b);
       int ci = v_compare(ea, eb);
       if (ci != 0) {
         return ci;
@@ -409,10 +754,12 @@ void v_add(var_t *result, var_t *a, var_t *b) {
   char tmpsb[INT_STR_LEN];
 
   if (a->type == V_STR && b->type == V_STR) {
-    int length = strlen(a->v.p.ptr) + strlen(b->v.p.ptr);
-    v_init_str(result, length);
-    strcpy(result->v.p.ptr, a->v.p.ptr);
-    strcat(result->v.p.ptr, b->v.p.ptr);
+    int length_a = v_strlen(a);
+    int length_b = v_strlen(b);
+    v_init_str(result, length_a + length_b);
+    memcpy(result->v.p.ptr, a->v.p.ptr, length_a);
+    memcpy(result->v.p.ptr + length_a, b->v.p.ptr, length_b);
+    result->v.p.ptr[length_a + length_b] = '\0';
     return;
   } else if (a->type == V_INT && b->type == V_INT) {
     result->type = V_INT;
@@ -478,8 +825,22 @@ void v_add(var_t *result, var_t *a, var_t *b) {
 
 /*
  * assign (dest = src)
+ *
+ * strings and arrays share the source text or elements by reference count,
+ * an array is copied when it is next changed. arrays are copied immediately
+ * while v_share_lock is held
  */
 void v_set(var_t *dest, const var_t *src) {
+  if (dest == src) {
+    return;
+  }
+  if (src->type == V_STR && src->v.p.owner == V_STR_COUNTED) {
+    // take the reference before dest is released, dest may hold the last one
+    v_refs_str(src)++;
+  } else if (src->type == V_ARRAY && v_asize(src) && !v_share_lock) {
+    v_refs(src)++;
+    v_dims_refs(src)++;
+  }
   v_free(dest);
   dest->const_flag = 0;
   dest->type = src->type;
@@ -492,22 +853,31 @@ void v_set(var_t *dest, const var_t *src) {
     dest->v.n = src->v.n;
     break;
   case V_STR:
-    if (src->v.p.owner) {
-      dest->v.p.length = v_strlen(src) + 1;
-      dest->v.p.ptr = (char *)malloc(dest->v.p.length);
-      dest->v.p.owner = 1;
-      strcpy(dest->v.p.ptr, src->v.p.ptr);
+    if (src->v.p.owner == V_STR_COUNTED) {
+      dest->v.p.length = src->v.p.length;
+      dest->v.p.ptr = src->v.p.ptr;
+      dest->v.p.owner = V_STR_COUNTED;
+    } else if (src->v.p.owner) {
+      int length = v_strlen(src);
+      dest->v.p.length = length + 1;
+      dest->v.p.ptr = (char *)v_block_alloc(length + 1);
+      dest->v.p.owner = V_STR_COUNTED;
+      memcpy(dest->v.p.ptr, src->v.p.ptr, length);
+      dest->v.p.ptr[length] = '\0';
     } else {
       dest->v.p.length = src->v.p.length;
       dest->v.p.ptr = src->v.p.ptr;
-      dest->v.p.owner = 0;
+      dest->v.p.owner = V_STR_SHARED;
     }
     break;
   case V_ARRAY:
-    if (v_asize(src)) {
+    if (!v_asize(src)) {
+      v_init_array(dest);
+    } else if (v_share_lock) {
       v_copy_array(dest, src);
     } else {
-      v_init_array(dest);
+      memcpy(&dest->v.a, &src->v.a, sizeof(src->v.a));
+      v_packed(dest) = v_packed(src);
     }
     break;
   case V_PTR:
@@ -550,10 +920,12 @@ void v_move(var_t *dest, const var_t *src) {
   case V_STR:
     dest->v.p.ptr = src->v.p.ptr;
     dest->v.p.length = src->v.p.length;
+    dest->v.p.capacity = src->v.p.capacity;
     dest->v.p.owner = src->v.p.owner;
     break;
   case V_ARRAY:
     memcpy(&dest->v.a, &src->v.a, sizeof(src->v.a));
+    v_packed(dest) = v_packed(src);
     break;
   case V_PTR:
     dest->v.ap.p = src->v.ap.p;
@@ -680,18 +1052,20 @@ void v_tostr(var_t *arg) {
  * set the value of 'var' to string
  */
 void v_setstr(var_t *var, const char *str) {
-  if (var->type != V_STR || strcmp(str, var->v.p.ptr) != 0) {
+  int len = strlen(str);
+  if (var->type != V_STR || v_strlen(var) != len || memcmp(str, var->v.p.ptr, len) != 0) {
     v_free(var);
-    v_init_str(var, strlen(str));
-    strcpy(var->v.p.ptr, str);
+    v_init_str(var, len);
+    memcpy(var->v.p.ptr, str, len + 1);
   }
 }
 
 void v_setstrn(var_t *var, const char *str, int len) {
-  if (var->type != V_STR || strncmp(str, var->v.p.ptr, len) != 0) {
+  if (var->type != V_STR || v_strlen(var) != len || strncmp(str, var->v.p.ptr, len) != 0) {
     v_free(var);
     v_init_str(var, len);
-    strlcpy(var->v.p.ptr, str, len + 1);
+    memcpy(var->v.p.ptr, str, len);
+    var->v.p.ptr[len] = '\0';
   }
 }
 
@@ -699,23 +1073,55 @@ void v_setstrn(var_t *var, const char *str, int len) {
  * adds a string to current string value
  */
 void v_strcat(var_t *var, const char *str) {
+  v_strappend(var, str, strlen(str));
+}
+
+/*
+ * appends to the string value, growing the buffer geometrically
+ */
+void v_strappend(var_t *var, const char *str, int len) {
   if (var->type == V_INT || var->type == V_NUM) {
     v_tostr(var);
   }
   if (var->type == V_STR) {
-    if (var->v.p.owner) {
-      var->v.p.length = strlen(var->v.p.ptr) + strlen(str) + 1;
-      var->v.p.ptr = realloc(var->v.p.ptr, var->v.p.length);
-      strcat(var->v.p.ptr, str);
-    } else {
-      // mutate into owner string
-      char *p = var->v.p.ptr;
-      int len = var->v.p.length + strlen(str);
-      v_init_str(var, len);
-      strcpy(var->v.p.ptr, p);
-      strcat(var->v.p.ptr, str);
+    uint32_t length = v_strlen(var);
+    uint32_t required = length + len + 1;
+    if (var->v.p.owner != V_STR_BUFFER || var->v.p.capacity < required) {
+      uint32_t capacity = var->v.p.owner == V_STR_BUFFER ? var->v.p.capacity * 2 : length + 1;
+      if (capacity < required) {
+        capacity = required + required / 2;
+      }
+      char *ptr = var->v.p.ptr;
+      char *buffer;
+      int owner = var->v.p.owner;
+      if ((owner == V_STR_OWNER || owner == V_STR_BUFFER) &&
+          (str < ptr || str >= ptr + length)) {
+        buffer = realloc(ptr, capacity);
+      } else {
+        // shared text, or appending from within the existing text
+        buffer = malloc(capacity);
+        if (buffer) {
+          memcpy(buffer, ptr, length);
+          memcpy(buffer + length, str, len);
+          if (owner == V_STR_COUNTED) {
+            v_block_free(ptr);
+          } else if (owner != V_STR_SHARED) {
+            free(ptr);
+          }
+          str = buffer + length;
+        }
+      }
+      if (buffer == NULL) {
+        err_memory();
+        return;
+      }
+      var->v.p.ptr = buffer;
+      var->v.p.capacity = capacity;
+      var->v.p.owner = V_STR_BUFFER;
     }
-
+    memmove(var->v.p.ptr + length, str, len);
+    var->v.p.ptr[length + len] = '\0';
+    var->v.p.length = required;
   } else {
     err_typemismatch();
   }
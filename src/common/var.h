@@ -93,6 +93,31 @@ typedef struct lab_s {
   bcip_t ip;
 } lab_t;
 
+/**
+ * @ingroup exec
+ *
+ * a LOCAL variable or BYVAL parameter, held in the frame arena
+ */
+typedef struct frame_slot_s {
+  var_t var; /**< the variable */
+  var_t *vptr; /**< previous variable, NULL for an unbound argument */
+  bid_t vid; /**< variable index in tvar */
+} frame_slot_t;
+
+/**
+ * @ingroup exec
+ *
+ * a block of frame slots. blocks are chained and never moved, so the
+ * variables keep their address while the frame is active
+ */
+typedef struct frame_block_s {
+  struct frame_block_s *prev;
+  struct frame_block_s *next;
+  uint32_t size; /**< number of slots */
+  uint32_t count; /**< slots in use */
+  frame_slot_t slots[];
+} frame_block_t;
+
 /**
  * @ingroup exec
  * @struct stknode_s
@@ -111,6 +136,8 @@ typedef struct stknode_s {
       bcip_t step_expr_ip; /**< IP of 'STEP' expression (FOR-IN = current element) */
       bcip_t jump_ip; /**< code block IP */
       bcip_t exit_ip; /**< EXIT command IP to go */
+      var_int_t to_int; /**< integer FOR-TO limit, or the limit variable index */
+      var_int_t step_int; /**< integer FOR-TO step */
       code_t subtype; /**< kwTO | kwIN */
       byte flags; /**< ... */
     } vfor;
@@ -153,22 +180,32 @@ typedef struct stknode_s {
       bid_t rvid;      /**< return-variable ID */
       int task_id; /**< task_id or -1 (this task) */
       uint16_t pcount; /**< number of parameters */
+      uint16_t locks;  /**< v_share_lock held for BYREF array elements */
     } vcall;
 
     /**
-     *  Create dynamic variable (LOCAL or PARAMETER)
+     *  BYREF parameter or FUNC result
      */
     struct {
       var_t *vptr; /**< previous variable */
       bid_t vid; /**< variable index in tvar */
     } vdvar;
 
+    /**
+     *  LOCAL variables and BYVAL parameters (kwTYPE_CRVAR)
+     */
+    struct {
+      frame_block_t *block; /**< the block holding the slots */
+      frame_slot_t *slots; /**< the first slot */
+      uint32_t count; /**< number of slots */
+    } vframe;
+
     /**
      *  parameter (CALL UDP/F)
      */
     struct {
       var_t *res; /**< variable pointer (for BYVAL this is a clone) */
-      uint16_t vcheck; /**< checks (1=BYVAL ONLY, 3=BYVAL|BYREF, 2=BYREF ONLY) */
+      uint16_t vcheck; /**< checks (1=BYVAL ONLY, 3=BYVAL|BYREF, 2=BYREF ONLY, 4=ELEMENT) */
     } param;
 
     /**
@@ -187,13 +224,36 @@ typedef struct stknode_s {
   code_t type; /**< type of node (keyword id, i.e. kwGOSUB, kwFOR, etc) */
 } stknode_t;
 
+/**
+ * @ingroup var
+ * @typedef var_pool_stats_t
+ *
+ * var pool statistics
+ */
+typedef struct var_pool_stats_s {
+  uint64_t hits; /**< variables reused from the free list */
+  uint64_t misses; /**< variables taken from a chunk */
+  uint32_t used; /**< variables in use */
+  uint32_t high_water; /**< the most variables in use at once */
+  uint32_t chunks; /**< chunks allocated */
+} var_pool_stats_t;
+
+extern var_pool_stats_t v_pool_stats;
+
 /**
  * @ingroup var
  *
- * intialises the var pool
+ * intialises the var pool, any variables still held are reclaimed
  */
 void v_init_pool(void);
 
+/**
+ * @ingroup var
+ *
+ * releases the var pool. the statistics are kept until the next v_init_pool()
+ */
+void v_free_pool(void);
+
 /**
  * @ingroup var
  *
@@ -201,6 +261,21 @@ void v_init_pool(void);
  */
 void v_pool_free(var_t *var);
 
+/**
+ * @ingroup var
+ *
+ * releases a reference to array elements or to counted string text
+ */
+void v_block_free(void *data);
+
+/**
+ * @ingroup var
+ *
+ * non-zero while a pointer to an array element is held across an
+ * evaluation. arrays are then copied rather than shared by v_set()
+ */
+extern int v_share_lock;
+
 /**
  * @ingroup var
  *
@@ -301,6 +376,16 @@ int code_pop_and_free();
  */
 stknode_t *code_stackpeek();
 
+/**
+ * @ingroup exec
+ *
+ * makes the node a kwTYPE_CRVAR frame of count slots in a new block of the
+ * frame arena (the slow path of frame_alloc())
+ *
+ * @return the first slot, or NULL on error
+ */
+frame_slot_t *frame_grow(stknode_t *node, uint32_t count);
+
 /**
  * @ingroup var
  *
@@ -131,6 +131,43 @@ var_t *code_getvarptr_arridx(var_t *basevar_p) {
   return var_p;
 }
 
+/**
+ * Returns the element index for the packed array returned by code_getvar_packed(),
+ * or INVALID_ADDR when the element is further dereferenced, in which case var_p
+ * is assigned the resolved variable
+ */
+bcip_t code_get_packed_idx(var_t *array, var_t **var_p) {
+  bcip_t result = INVALID_ADDR;
+  *var_p = NULL;
+  code_skipnext();
+  bcip_t array_index = get_array_idx(array);
+  if (!prog_error) {
+    if (array->type != V_ARRAY || (int) array_index >= v_asize(array) || (int) array_index < 0) {
+      err_arridx(array_index, array->type == V_ARRAY ? v_asize(array) : 0);
+    } else if (code_peek() != kwTYPE_LEVEL_END) {
+      err_arrmis_rp();
+    } else {
+      code_skipnext();
+      switch (code_peek()) {
+      case kwTYPE_LEVEL_BEGIN:
+        if (v_packed(array) || v_data(array)[array_index].type != V_ARRAY) {
+          err_varisnotarray();
+        } else {
+          // there is a second array inside
+          *var_p = code_getvarptr_arridx(v_elem(array, array_index));
+        }
+        break;
+      case kwTYPE_UDS_EL:
+        *var_p = code_resolve_varptr(v_elem(array, array_index), 0);
+        break;
+      default:
+        result = array_index;
+      }
+    }
+  }
+  return result;
+}
+
 var_t *code_get_map_element(var_t *map, var_t *field) {
   var_t *result = NULL;
 
@@ -279,7 +316,12 @@ int code_isvar() {
 
     code_skipnext();
     var_t *var_p = basevar_p = tvar[code_getaddr()];
-    switch (basevar_p->type) {
+    if (basevar_p->type == V_ARRAY && v_packed(basevar_p) && code_peek() == kwTYPE_LEVEL_BEGIN) {
+      // resolve the index without unpacking the elements
+      if (code_get_packed_idx(basevar_p, &var_p) != INVALID_ADDR) {
+        var_p = basevar_p;
+      }
+    } else switch (basevar_p->type) {
     case V_MAP:
       is_ptr = 0;
       var_p = code_isvar_resolve_map(var_p, &is_ptr);
@@ -318,6 +360,23 @@ int code_isvar() {
   return 0;
 }
 
+/**
+ * returns true if the next code is a variable which can be read in place. an
+ * element of a packed, shared or SEARCH indexed array is left to eval() rather
+ * than unpacking or copying the array or dropping the index
+ */
+int code_isvar_inplace() {
+  if (code_peek() == kwTYPE_VAR) {
+    var_t *var_p = tvar[code_peekaddr(prog_ip + 1)];
+    if (var_p->type == V_ARRAY &&
+        (v_packed(var_p) || v_shared(var_p) || v_data(var_p) == v_indexed_data) &&
+        prog_source[prog_ip + 1 + ADDRSZ] == kwTYPE_LEVEL_BEGIN) {
+      return 0;
+    }
+  }
+  return code_isvar();
+}
+
 var_t *eval_ref_var(var_t *var_p) {
   var_t *result = var_p;
   while (result != NULL && result->type == V_REF) {
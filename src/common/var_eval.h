@@ -42,6 +42,14 @@ var_t *code_resolve_map(var_t *var_p, int until_parens);
  */
 var_t *code_resolve_varptr(var_t *var_p, int until_parens);
 
+/**
+ * @ingroup var
+ *
+ * returns the index of the packed or shared array element or INVALID_ADDR when
+ * the element is dereferenced further into var_p, or on error
+ */
+bcip_t code_get_packed_idx(var_t *array, var_t **var_p);
+
 /**
  * @ingroup var
  *
@@ -58,6 +66,16 @@ var_t *eval_ref_var(var_t *var_p);
  */
 int code_isvar(void);
 
+/**
+ * @ingroup exec
+ *
+ * returns true if the next code is a single variable which can be
+ * read without converting a packed or shared array
+ *
+ * @return non-zero if the following code is a variable
+ */
+int code_isvar_inplace(void);
+
 /**
  * @ingroup var
  *
@@ -12,40 +12,58 @@
 #include "common/pproc.h"
 #include "common/hashmap.h"
 #include "include/var_map.h"
-#include "lib/jsmn.h"
 
-#define BUFFER_GROW_SIZE 64
-#define BUFFER_PADDING   10
-#define TOKEN_GROW_SIZE  16
-#define ARRAY_GROW_SIZE  8
+#define BUFFER_GROW_SIZE  64
+#define TEXT_GROW_SIZE    256
+#define ARRAY_GROW_SIZE   8
+#define WRITER_BLOCK_SIZE 4096
+#define READER_BLOCK_SIZE 65536
 
 /**
- * Container for map_from_str
+ * Input for the JSON parser. The text is either held in memory
+ * or read from the file handle one block at a time.
  */
-typedef struct JsonTokens {
-  const char *js;
-  jsmntok_t *tokens;
-  int num_tokens;
-  int code_array;
-} JsonTokens;
+typedef struct JsonReader {
+  const char *data;
+  uint32_t pos;
+  uint32_t length;
+  int handle;
+  uint32_t unread;
+  char *block;
+  char *text;
+  uint32_t text_size;
+  int matrix;
+} JsonReader;
 
-struct ArrayNode;
-typedef struct ArrayNode {
-  var_t *v;
-  int col;
-  int row;
-  struct ArrayNode *next;
-} ArrayNode;
+/**
+ * Output buffer for json_write
+ */
+typedef struct JsonWriter {
+  char *buffer;
+  uint32_t length;
+  uint32_t size;
+  int method;
+  intptr_t handle;
+} JsonWriter;
+
+/**
+ * Array element awaiting its final position
+ */
+typedef struct ArrayElem {
+  var_t v;
+  uint32_t row;
+  uint32_t col;
+} ArrayElem;
 
 typedef struct ArrayList {
-  ArrayNode *head;
-  ArrayNode *tail;
+  ArrayElem *elems;
+  uint32_t count;
+  uint32_t size;
 } ArrayList;
 
-/**
- * Process the next token
- */
-int map_read_next_token(var_p_t dest, JsonTokens *json, int index);
+void json_parse_value(JsonReader *reader, var_p_t dest);
+void json_write_var(JsonWriter *writer, var_t *var);
+void json_flush(JsonWriter *writer);
 
 /**
  * initialise the variable as a map
@@ -133,32 +151,13 @@ const char *map_get_str(var_p_t base, const char *name) {
   return result;
 }
 
-/**
- * return the element at the nth position
- */
-int map_elem_cb(hashmap_cb *cb, var_p_t key, var_p_t value) {
-  int result;
-  if (cb->count++ == cb->index) {
-    cb->var = key;
-    result = 1;
-  } else {
-    result = 0;
-  }
-  return result;
-}
-
 /**
  * return the element key at the nth position
  */
 var_p_t map_elem_key(const var_p_t var_p, int index) {
   var_p_t result;
   if (var_p->type == V_MAP) {
-    hashmap_cb cb;
-    cb.count = 0;
-    cb.index = index;
-    cb.var = NULL;
-    hashmap_foreach(var_p, map_elem_cb, &cb);
-    result = cb.var;
+    result = hashmap_get_key(var_p, index);
   } else {
     result = NULL;
   }
@@ -289,7 +288,6 @@ void map_set(var_p_t dest, const var_p_t src) {
     cb.var = dest;
     hashmap_create(dest, src->v.m.count);
     hashmap_foreach(src, map_set_cb, &cb);
-    dest->v.m.count = src->v.m.count;
   }
 }
 
@@ -303,55 +301,100 @@ void map_set_int(var_p_t base, const char *name, var_int_t n) {
 }
 
 /**
- * Helper for map_to_str
+ * Appends the text to the output, flushing to the file or socket
+ * when streaming, otherwise growing the buffer
  */
-int map_to_str_cb(hashmap_cb *cb, var_p_t v_key, var_p_t v_var) {
-  char *key = v_str(v_key);
-  char *value = v_str(v_var);
-  int required = strlen(cb->buffer) + strlen(key) + strlen(value) + BUFFER_PADDING;
-  if (required >= cb->count) {
-    cb->count = required + BUFFER_GROW_SIZE;
-    cb->buffer = realloc(cb->buffer, cb->count);
+void json_write(JsonWriter *writer, const char *text, uint32_t length) {
+  uint32_t required = writer->length + length + 1;
+  if (required > writer->size && writer->method != PV_STRING && writer->length) {
+    json_flush(writer);
+    required = length + 1;
+  }
+  if (required > writer->size) {
+    uint32_t size = writer->size * 2;
+    if (size < required) {
+      size = required + BUFFER_GROW_SIZE;
+    }
+    char *buffer = realloc(writer->buffer, size);
+    if (buffer == NULL) {
+      err_memory();
+      return;
+    }
+    writer->buffer = buffer;
+    writer->size = size;
+  }
+  memcpy(writer->buffer + writer->length, text, length);
+  writer->length += length;
+}
+
+/**
+ * Writes any buffered output to the file or socket
+ */
+void json_flush(JsonWriter *writer) {
+  if (writer->length) {
+    writer->buffer[writer->length] = '\0';
+    pv_write(writer->buffer, writer->method, writer->handle);
+    writer->length = 0;
+  }
+}
+
+static inline void json_write_char(JsonWriter *writer, char c) {
+  json_write(writer, &c, 1);
+}
+
+/**
+ * Writes the numeric value without an intermediate allocation
+ */
+static void json_write_num(JsonWriter *writer, var_t *var) {
+  char buffer[64];
+  if (var->type == V_INT) {
+    ltostr(var->v.i, buffer);
+  } else {
+    ftostr(var->v.n, buffer);
   }
+  json_write(writer, buffer, strlen(buffer));
+}
+
+/**
+ * Helper for json_write_var
+ */
+int json_write_cb(hashmap_cb *cb, var_p_t v_key, var_p_t v_var) {
+  JsonWriter *writer = (JsonWriter *)cb->buffer;
   if (!cb->start) {
-    strcat(cb->buffer, ",");
+    json_write_char(writer, ',');
   }
   cb->start = 0;
-  strcat(cb->buffer, "\"");
-  strcat(cb->buffer, key);
-  strcat(cb->buffer, "\"");
-  strcat(cb->buffer, ":");
+  json_write_char(writer, '"');
+  json_write(writer, v_key->v.p.ptr, v_strlen(v_key));
+  json_write(writer, "\":", 2);
   if (v_var->type == V_STR) {
-    strcat(cb->buffer, "\"");
-  }
-  strcat(cb->buffer, value);
-  if (v_var->type == V_STR) {
-    strcat(cb->buffer, "\"");
+    json_write_char(writer, '"');
+    json_write_var(writer, v_var);
+    json_write_char(writer, '"');
+  } else {
+    json_write_var(writer, v_var);
   }
-  free(key);
-  free(value);
   return 0;
 }
 
 /**
- * Print the array element, growing the buffer as needed
+ * Writes the array element, packed elements are not expanded
  */
-void array_append_elem(hashmap_cb *cb, var_t *elem) {
-  char *value = v_str(elem);
-  int required = strlen(cb->buffer) + strlen(value) + BUFFER_PADDING;
-  if (required >= cb->count) {
-    cb->count = required + BUFFER_GROW_SIZE;
-    cb->buffer = realloc(cb->buffer, cb->count);
+static void json_write_elem(JsonWriter *writer, var_t *var, int pos) {
+  if (v_packed(var)) {
+    var_t elem;
+    v_packed_get(var, pos, &elem);
+    json_write_num(writer, &elem);
+  } else {
+    json_write_var(writer, v_elem(var, pos));
   }
-  strcat(cb->buffer, value);
-  free(value);
 }
 
 /**
- * print the array variable
+ * Writes the array variable
  */
-void array_to_str(hashmap_cb *cb, var_t *var) {
-  strcpy(cb->buffer, "[");
+static void json_write_array(JsonWriter *writer, var_t *var) {
+  json_write_char(writer, '[');
   if (v_maxdim(var) == 2) {
     // NxN
     int rows = ABS(v_ubound(var, 0) - v_lbound(var, 0)) + 1;
@@ -359,56 +402,98 @@ void array_to_str(hashmap_cb *cb, var_t *var) {
 
     for (int i = 0; i < rows; i++) {
       for (int j = 0; j < cols; j++) {
-        int pos = i * cols + j;
-        var_t *elem = v_elem(var, pos);
-        array_append_elem(cb, elem);
+        json_write_elem(writer, var, i * cols + j);
         if (j != cols - 1) {
-          strcat(cb->buffer, ",");
+          json_write_char(writer, ',');
         }
       }
       if (i != rows - 1) {
-        strcat(cb->buffer, ";");
+        json_write_char(writer, ';');
       }
     }
   } else {
     for (int i = 0; i < v_asize(var); i++) {
-      var_t *elem = v_elem(var, i);
-      array_append_elem(cb, elem);
+      json_write_elem(writer, var, i);
       if (i != v_asize(var) - 1) {
-        strcat(cb->buffer, ",");
+        json_write_char(writer, ',');
       }
     }
   }
-  strcat(cb->buffer, "]");
+  json_write_char(writer, ']');
 }
 
 /**
- * Return the contents of the structure as a string
+ * Writes the variable in the same format as v_str()
  */
-char *map_to_str(const var_p_t var_p) {
+void json_write_var(JsonWriter *writer, var_t *var) {
   hashmap_cb cb;
-  cb.count = BUFFER_GROW_SIZE;
-  cb.buffer = malloc(cb.count);
+  char *value;
 
-  if (var_p->type == V_MAP) {
+  switch (var->type) {
+  case V_INT:
+  case V_NUM:
+    json_write_num(writer, var);
+    break;
+  case V_STR:
+    json_write(writer, var->v.p.ptr, v_strlen(var));
+    break;
+  case V_MAP:
+    // the writer is passed through the callback buffer
     cb.start = 1;
-    strcpy(cb.buffer, "{");
-    hashmap_foreach(var_p, map_to_str_cb, &cb);
-    strcat(cb.buffer, "}");
-  } else if (var_p->type == V_ARRAY) {
-    array_to_str(&cb, var_p);
+    cb.buffer = (char *)writer;
+    json_write_char(writer, '{');
+    hashmap_foreach(var, json_write_cb, &cb);
+    json_write_char(writer, '}');
+    break;
+  case V_ARRAY:
+    json_write_array(writer, var);
+    break;
+  default:
+    value = v_str(var);
+    json_write(writer, value, strlen(value));
+    free(value);
+    break;
   }
-  return cb.buffer;
 }
 
 /**
- * Print the contents of the structure
+ * Return the contents of the structure as a string
+ */
+char *map_to_str(const var_p_t var_p) {
+  JsonWriter writer;
+  writer.size = BUFFER_GROW_SIZE;
+  writer.length = 0;
+  writer.buffer = malloc(writer.size);
+  writer.method = PV_STRING;
+  writer.handle = 0;
+  if (var_p->type == V_MAP || var_p->type == V_ARRAY) {
+    json_write_var(&writer, var_p);
+  }
+  writer.buffer[writer.length] = '\0';
+  return writer.buffer;
+}
+
+/**
+ * Print the contents of the structure. Files and sockets are written
+ * in blocks as the output is produced
  */
 void map_write(const var_p_t var_p, int method, intptr_t handle) {
   if (var_p->type == V_MAP || var_p->type == V_ARRAY) {
-    char *buffer = map_to_str(var_p);
-    pv_write(buffer, method, handle);
-    free(buffer);
+    if (method == PV_FILE || method == PV_NET) {
+      JsonWriter writer;
+      writer.size = WRITER_BLOCK_SIZE;
+      writer.length = 0;
+      writer.buffer = malloc(writer.size);
+      writer.method = method;
+      writer.handle = handle;
+      json_write_var(&writer, var_p);
+      json_flush(&writer);
+      free(writer.buffer);
+    } else {
+      char *buffer = map_to_str(var_p);
+      pv_write(buffer, method, handle);
+      free(buffer);
+    }
   }
 }
 
@@ -442,181 +527,368 @@ void map_set_primative(var_p_t dest, const char *s, int len) {
 }
 
 /**
- * Adds a node to the array list
+ * Adds an element to the array list
  */
-var_t *map_array_list_add(ArrayList *list, int row, int col) {
-  if (list->head == NULL) {
-    list->head = malloc(sizeof(ArrayNode));
-    list->tail = list->head;
-  } else {
-    list->tail->next = malloc(sizeof(ArrayNode));
-    list->tail = list->tail->next;
+var_t *map_array_list_add(ArrayList *list, uint32_t row, uint32_t col) {
+  if (list->count == list->size) {
+    list->size = list->size ? list->size * 2 : ARRAY_GROW_SIZE;
+    list->elems = realloc(list->elems, list->size * sizeof(ArrayElem));
+  }
+  ArrayElem *elem = &list->elems[list->count++];
+  elem->row = row;
+  elem->col = col;
+  elem->v.pooled = 0;
+  v_init(&elem->v);
+  return &elem->v;
+}
+
+/**
+ * Releases the array list following an error
+ */
+void map_array_list_free(ArrayList *list) {
+  for (uint32_t i = 0; i < list->count; i++) {
+    v_free(&list->elems[i].v);
   }
-  list->tail->next = NULL;
-  list->tail->row = row;
-  list->tail->col = col;
-  list->tail->v = v_new();
-  return list->tail->v;
+  free(list->elems);
 }
 
 /**
- * Builds the array from the ArrayNode list
+ * Builds the array from the array list. The array is allocated once
+ * at its final size and the elements are moved into place.
  */
-void map_build_array(var_p_t dest, ArrayNode *node_next, int rows, int cols) {
+void map_build_array(var_p_t dest, ArrayList *list, int rows, int cols) {
   if (rows > 1) {
     v_tomatrix(dest, rows, cols);
   } else {
     v_toarray1(dest, cols);
   }
-  while (node_next) {
-    int pos = node_next->row * cols + node_next->col;
-    v_set(v_elem(dest, pos), node_next->v);
-    v_free(node_next->v);
-    v_detach(node_next->v);
-    ArrayNode *next = node_next->next;
-    free(node_next);
-    node_next = next;
+  for (uint32_t i = 0; i < list->count; i++) {
+    ArrayElem *elem = &list->elems[i];
+    var_t *dest_elem = v_elem(dest, elem->row * cols + elem->col);
+    v_free(dest_elem);
+    memcpy(dest_elem, &elem->v, sizeof(var_t));
   }
+  free(list->elems);
 }
 
 /**
- * Creates an array variable
+ * Reads the next block from the file, returns whether text is available
  */
-int map_create_array(var_p_t dest, JsonTokens *json, int end_position, int index) {
-  int i = index;
-  int rows = 0;
-  int cols = 0;
-  int curcol = 0;
-  ArrayList list;
+static int json_fill(JsonReader *reader) {
+  if (reader->pos == reader->length && reader->unread) {
+    uint32_t size = I2MIN(reader->unread, READER_BLOCK_SIZE);
+    if (dev_fread(reader->handle, (byte *)reader->block, size)) {
+      reader->block[size] = '\0';
+      reader->data = reader->block;
+      reader->pos = 0;
+      reader->length = size;
+      reader->unread -= size;
+    } else {
+      reader->unread = 0;
+    }
+  }
+  return reader->pos < reader->length;
+}
 
-  list.head = NULL;
-  list.tail = NULL;
+/**
+ * Returns the next character, or the null character at the end of the text
+ */
+static inline int json_peek(JsonReader *reader) {
+  if (reader->pos == reader->length && !json_fill(reader)) {
+    return '\0';
+  }
+  return (unsigned char)reader->data[reader->pos];
+}
 
-  while (i < json->num_tokens) {
-    jsmntok_t token = json->tokens[i];
-    if (token.start > end_position) {
+/**
+ * Skips white space and separators, returning the next character
+ */
+static int json_skip(JsonReader *reader) {
+  int c;
+  while (1) {
+    c = json_peek(reader);
+    if (c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != ',' && c != ':') {
       break;
     }
-    var_t *elem = map_array_list_add(&list, rows, curcol++);
-    if (token.type == JSMN_PRIMITIVE && json->tokens[0].type == JSMN_ARRAY) {
-      int len = token.end - token.start;
-      const char *str = json->js + token.start;
-      const char *delim = memchr(str, ';', len);
-      if (delim != NULL) {
-        if ((delim - str) > 0) {
-          map_set_primative(elem, str, delim - str);
-          if (curcol > cols) {
-            cols = curcol;
-          }
-        }
-        while (delim != NULL) {
-          rows++;
-          curcol = 0;
-          len -= (delim - str) + 1;
-          if (len > 0) {
-            // text exists beyond ';'
-            str = ++delim;
-            if (*str != ';') {
-              elem = map_array_list_add(&list, rows, curcol++);
-              map_set_primative(elem, str, len);
-            }
-            delim = memchr(str, ';', len);
-          } else {
-            // no more text, just count the new row
-            delim = NULL;
-          }
+    reader->pos++;
+  }
+  return c;
+}
+
+/**
+ * Appends the current block from start to the token text
+ */
+static void json_keep(JsonReader *reader, uint32_t start, uint32_t *used) {
+  uint32_t length = reader->pos - start;
+  uint32_t required = *used + length + 1;
+  if (required > reader->text_size) {
+    uint32_t size = reader->text_size ? reader->text_size : TEXT_GROW_SIZE;
+    while (size < required) {
+      size *= 2;
+    }
+    reader->text = realloc(reader->text, size);
+    reader->text_size = size;
+  }
+  memcpy(reader->text + *used, reader->data + start, length);
+  *used += length;
+  reader->text[*used] = '\0';
+}
+
+/**
+ * Returns whether the primitive ends at the given character
+ */
+static inline int json_is_delim(int c, int row_delim) {
+  switch (c) {
+  case '\0':
+  case '\t':
+  case '\r':
+  case '\n':
+  case ' ':
+  case ',':
+  case ']':
+  case '}':
+  case ':':
+    return 1;
+  case ';':
+    return row_delim;
+  default:
+    return 0;
+  }
+}
+
+/**
+ * Scans the string or primitive starting at the current position. String
+ * escapes are validated but retained. The result refers to the input text
+ * unless the token spans more than one block.
+ */
+static const char *json_scan(JsonReader *reader, int string, int row_delim, uint32_t *length) {
+  uint32_t start = reader->pos;
+  uint32_t used = 0;
+  int spilled = 0;
+  int escape = 0;
+  int hex = 0;
+  int done = 0;
+
+  while (!done && !prog_error) {
+    if (reader->pos == reader->length) {
+      json_keep(reader, start, &used);
+      spilled = 1;
+      if (!json_fill(reader)) {
+        if (string) {
+          // unterminated string
+          err_array();
         }
-      } else {
-        map_set_primative(elem, json->js + token.start, token.end - token.start);
+        break;
       }
-      i++;
-    } else {
-      i = map_read_next_token(elem, json, i);
+      start = reader->pos;
+    }
+    char c = reader->data[reader->pos];
+    if (!string) {
+      if (json_is_delim(c, row_delim)) {
+        done = 1;
+      } else if (c < 32 || c >= 127) {
+        err_array();
+      }
+    } else if (hex) {
+      if (!isxdigit(c)) {
+        err_array();
+      }
+      hex--;
+    } else if (escape) {
+      switch (c) {
+      case '\"': case '/': case '\\': case 'b':
+      case 'f': case 'r': case 'n': case 't':
+        break;
+      case 'u':
+        hex = 4;
+        break;
+      default:
+        err_array();
+      }
+      escape = 0;
+    } else if (c == '\\') {
+      escape = 1;
+    } else if (c == '\"') {
+      done = 1;
+    } else if (c == '\0') {
+      err_array();
     }
-    if (curcol > cols) {
-      cols = curcol;
+    if (!done) {
+      reader->pos++;
     }
   }
-  map_build_array(dest, list.head, rows+1, cols);
-  return i;
+
+  const char *result;
+  if (spilled) {
+    json_keep(reader, start, &used);
+    result = reader->text;
+    *length = used;
+  } else {
+    result = reader->data + start;
+    *length = reader->pos - start;
+  }
+  if (string && done) {
+    // skip the closing quote
+    reader->pos++;
+  }
+  return result;
 }
 
 /**
  * Creates a map variable
  */
-int map_create(var_p_t dest, JsonTokens *json, int end_position, int index) {
+static void json_parse_object(JsonReader *reader, var_p_t dest) {
   hashmap_create(dest, 0);
-  int i = index;
-  while (i < json->num_tokens) {
-    jsmntok_t token = json->tokens[i];
-    if (token.start > end_position) {
+  int c;
+  while (!prog_error && (c = json_skip(reader)) != '}') {
+    uint32_t length;
+    const char *text;
+    if (c == '\"') {
+      reader->pos++;
+      text = json_scan(reader, 1, 0, &length);
+    } else if (c == '\0' || c == ']' || c == '{' || c == '[') {
+      err_array();
       break;
-    } else if (token.type == JSMN_STRING || token.type == JSMN_PRIMITIVE) {
-      var_p_t key = v_new();
-      map_set_primative(key, json->js + token.start, token.end - token.start);
-      var_p_t value = hashmap_putv(dest, key);
-      i = map_read_next_token(value, json, i + 1);
     } else {
+      text = json_scan(reader, 0, 0, &length);
+    }
+    if (!prog_error) {
+      var_p_t key = v_new();
+      map_set_primative(key, text, length);
+      json_parse_value(reader, hashmap_putv(dest, key));
+    }
+  }
+  if (!prog_error) {
+    reader->pos++;
+  }
+}
+
+/**
+ * Creates an array variable. When the outer value is an array, the
+ * semicolon separates the rows of a matrix.
+ */
+static void json_parse_array(JsonReader *reader, var_p_t dest) {
+  ArrayList list = {NULL, 0, 0};
+  uint32_t row = 0;
+  uint32_t col = 0;
+  uint32_t cols = 0;
+  int c;
+
+  while (!prog_error && (c = json_skip(reader)) != ']') {
+    if (c == '\0' || c == '}') {
       err_array();
-      break;
+    } else if (c == ';' && reader->matrix) {
+      reader->pos++;
+      row++;
+      col = 0;
+    } else {
+      var_t *elem = map_array_list_add(&list, row, col++);
+      if (c == '{' || c == '[' || c == '\"') {
+        json_parse_value(reader, elem);
+      } else {
+        uint32_t length;
+        const char *text = json_scan(reader, 0, reader->matrix, &length);
+        if (!prog_error) {
+          map_set_primative(elem, text, length);
+        }
+      }
+      if (col > cols) {
+        cols = col;
+      }
     }
   }
-  return i;
+  if (prog_error) {
+    map_array_list_free(&list);
+  } else {
+    reader->pos++;
+    map_build_array(dest, &list, row + 1, cols);
+  }
 }
 
 /**
- * Process the next token
+ * Process the next value
  */
-int map_read_next_token(var_p_t dest, JsonTokens *json, int index) {
-  int next;
-  jsmntok_t token = json->tokens[index];
-  switch (token.type) {
-  case JSMN_OBJECT:
-    next = map_create(dest, json, token.end, index + 1);
+void json_parse_value(JsonReader *reader, var_p_t dest) {
+  uint32_t length;
+  const char *text;
+  int c = json_skip(reader);
+  switch (c) {
+  case '{':
+    reader->pos++;
+    json_parse_object(reader, dest);
     break;
-  case JSMN_ARRAY:
-    next = map_create_array(dest, json, token.end, index + 1);
+  case '[':
+    reader->pos++;
+    json_parse_array(reader, dest);
     break;
-  case JSMN_PRIMITIVE:
-    map_set_primative(dest, json->js + token.start, token.end - token.start);
-    next = index + 1;
+  case '\"':
+    reader->pos++;
+    text = json_scan(reader, 1, 0, &length);
+    if (!prog_error) {
+      v_setstrn(dest, text, length);
+    }
     break;
-  case JSMN_STRING:
-    v_setstrn(dest, json->js + token.start, token.end - token.start);
-    next = index + 1;
+  case '\0':
+  case ']':
+  case '}':
+    err_array();
     break;
   default:
-    next = -1;
+    text = json_scan(reader, 0, 0, &length);
+    if (!prog_error) {
+      map_set_primative(dest, text, length);
+    }
     break;
   }
-  return next;
 }
 
-void map_parse_str(const char *js, size_t len, var_p_t dest) {
-  int num_tokens = TOKEN_GROW_SIZE;
-  jsmntok_t *tokens = malloc(sizeof(jsmntok_t) * num_tokens);
-  int result;
-  jsmn_parser parser;
-
-  jsmn_init(&parser);
-  for (result = jsmn_parse(&parser, js, len, tokens, num_tokens);
-       result == JSMN_ERROR_NOMEM;
-       result = jsmn_parse(&parser, js, len, tokens, num_tokens)) {
-    num_tokens += TOKEN_GROW_SIZE;
-    tokens = realloc(tokens, sizeof(jsmntok_t) * num_tokens);
+/**
+ * Parses the first value in the text, leaves dest unchanged when there is none.
+ * Any following values are checked for errors then discarded.
+ */
+static void json_parse(JsonReader *reader, var_p_t dest) {
+  int c = json_skip(reader);
+  if (c != '\0') {
+    reader->matrix = (c == '[');
+    v_free(dest);
+    json_parse_value(reader, dest);
+
+    var_t next;
+    v_init(&next);
+    while (!prog_error && json_skip(reader) != '\0') {
+      json_parse_value(reader, &next);
+      v_free(&next);
+    }
+    if (prog_error) {
+      v_free(dest);
+    }
   }
-  if (result < 0) {
-    err_array();
-  } else if (result > 0) {
-    v_init(dest);
+  free(reader->text);
+}
+
+void map_parse_str(const char *js, size_t len, var_p_t dest) {
+  JsonReader reader;
+  memset(&reader, 0, sizeof(JsonReader));
+  reader.data = js;
+  reader.length = len;
+  reader.handle = -1;
+  json_parse(&reader, dest);
+}
 
-    JsonTokens json;
-    json.tokens = tokens;
-    json.js = js;
-    json.num_tokens = parser.toknext;
-    map_read_next_token(dest, &json, 0);
+/**
+ * Initialise a map from the remaining contents of the open file. The
+ * file is read in blocks so only the resulting variable is held in memory.
+ */
+void map_parse_file(var_p_t dest, int handle) {
+  JsonReader reader;
+  memset(&reader, 0, sizeof(JsonReader));
+  reader.handle = handle;
+  reader.unread = dev_flength(handle) - dev_ftell(handle);
+  if (!prog_error) {
+    reader.block = malloc(READER_BLOCK_SIZE + 1);
+    json_parse(&reader, dest);
+    free(reader.block);
   }
-  free(tokens);
 }
 
 /**
@@ -644,10 +916,7 @@ void map_from_codearray(var_p_t dest) {
   int curcol = 0;
   int ready = 0;
   int seps = 0;
-  ArrayList list;
-
-  list.head = NULL;
-  list.tail = NULL;
+  ArrayList list = {NULL, 0, 0};
 
   do {
     switch (code_peek()) {
@@ -672,9 +941,12 @@ void map_from_codearray(var_p_t dest) {
     }
   } while (!ready && !prog_error);
 
-  if (!seps && list.head == NULL) {
+  if (prog_error) {
+    map_array_list_free(&list);
+  } else if (!seps && !list.count) {
+    free(list.elems);
     v_toarray1(dest, 0);
   } else {
-    map_build_array(dest, list.head, rows+1, cols+1);
+    map_build_array(dest, &list, rows+1, cols+1);
   }
 }
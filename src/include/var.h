@@ -42,6 +42,27 @@ typedef long int var_int_t;
 #define V_FUNC      7 /**< variable type, object method                @ingroup var */
 #define V_NIL       8 /**< variable type, null value                   @ingroup var */
 
+/*
+ * Array - element storage
+ */
+#define V_PACKED_NONE 0 /**< array elements are var_t                     @ingroup var */
+#define V_PACKED_INT  1 /**< array elements are packed var_int_t          @ingroup var */
+#define V_PACKED_NUM  2 /**< array elements are packed var_num_t          @ingroup var */
+
+/*
+ * String - ownership
+ */
+#define V_STR_SHARED  0 /**< string text is held elsewhere                 @ingroup var */
+#define V_STR_OWNER   1 /**< string text is allocated to length            @ingroup var */
+#define V_STR_BUFFER  2 /**< string text is allocated to capacity          @ingroup var */
+#define V_STR_COUNTED 3 /**< string text is shared with a reference count  @ingroup var */
+
+/*
+ * Array elements and counted strings are preceded by a reference count.
+ * Assignment shares the storage, which is copied before it is changed
+ */
+#define V_REFS_SIZE 8 /**< bytes reserved for the reference count         @ingroup var */
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
@@ -49,6 +70,26 @@ extern "C" {
 struct var_s;
 typedef void (*method) (struct var_s *self);
 
+/**
+ * element slot of a packed numeric array
+ */
+typedef union var_pack_u {
+  var_int_t i;
+  var_num_t n;
+} var_pack_t;
+
+/**
+ * array dimensions, held apart from the variable and shared by reference
+ * count with the array elements
+ */
+typedef struct var_dims_s {
+  // upper and lower bounds
+  int32_t ubound[MAXDIM];
+  int8_t  lbound[MAXDIM];
+  // number of dimensions
+  uint8_t maxdim;
+} var_dims_t;
+
 typedef struct var_s {
   union {
     // numeric
@@ -84,22 +125,22 @@ typedef struct var_s {
     // generic ptr (string)
     struct {
       char *ptr;
+      // string length including the null terminator
       uint32_t length;
+      // allocated size when owner is V_STR_BUFFER
+      uint32_t capacity;
       uint8_t owner;
     } p;
 
     // array
     struct {
       struct var_s *data;
+      // bounds and number of dimensions
+      var_dims_t *dims;
       // the number of elements
       uint32_t size;
       // the number of available element slots
       uint32_t capacity;
-      // upper and lower bounds
-      int32_t ubound[MAXDIM];
-      int8_t  lbound[MAXDIM];
-      // number of dimensions
-      uint8_t maxdim;
     } a;
 
     // next item in the free-list
@@ -114,6 +155,9 @@ typedef struct var_s {
 
   // whether help in pooled memory
   uint8_t pooled;
+
+  // array element storage, see V_PACKED_NONE
+  uint8_t packed;
 } var_t;
 
 typedef var_t *var_p_t;
@@ -127,6 +171,57 @@ typedef var_t *var_p_t;
  */
 void v_new_array(var_t *var, unsigned size);
 
+/**
+ * @ingroup var
+ *
+ * creates a new variable array holding packed integer zero elements
+ */
+void v_new_packed_array(var_t *var, unsigned size);
+
+/**
+ * @ingroup var
+ *
+ * converts a packed array to var_t elements
+ */
+var_t *v_array_unpack(var_t *var);
+
+/**
+ * @ingroup var
+ *
+ * copies the array elements when they are shared with another array
+ */
+void v_array_unshare(var_t *var);
+
+/**
+ * @ingroup var
+ *
+ * returns the elements for writing, after they are unshared and unpacked
+ */
+var_t *v_array_data(var_t *var);
+
+/**
+ * @ingroup var
+ *
+ * returns the dimensions for writing, after they are unshared
+ */
+var_dims_t *v_array_dims(var_t *var);
+
+/**
+ * @ingroup var
+ *
+ * stores a numeric value in the packed array element.
+ *
+ * @return zero when the value is not numeric and was not stored
+ */
+int v_packed_store(var_t *var, uint32_t index, const var_t *value);
+
+/**
+ * @ingroup var
+ *
+ * assigns the packed array element to result
+ */
+void v_packed_get(const var_t *var, uint32_t index, var_t *result);
+
 /**
  * @ingroup var
  *
@@ -352,6 +447,18 @@ void v_setstrn(var_t *var, const char *string, int len);
  */
 void v_strcat(var_t *var, const char *string);
 
+/**
+ * @ingroup var
+ *
+ * appends len characters to the string variable 'var'. the variable
+ * becomes a V_STR_BUFFER with spare capacity for further appends
+ *
+ * @param var is the variable
+ * @param string is the string
+ * @param len the number of characters to append
+ */
+void v_strappend(var_t *var, const char *string, int len);
+
 /**
  * @ingroup var
  *
@@ -394,12 +501,52 @@ void v_zerostr(var_t *var);
  */
 void v_input2var(const char *str, var_t *var);
 
+/**
+ * < the reference count of the array elements (x)
+ * @ingroup var
+ */
+#define v_refs(x) (*(uint32_t *)((char *)(x)->v.a.data - V_REFS_SIZE))
+
+/**
+ * < whether the array elements are shared with another array (x)
+ * @ingroup var
+ */
+#define v_shared(x) ((x)->v.a.data != NULL && v_refs(x) > 1)
+
+/**
+ * < the reference count of the V_STR_COUNTED string text (x)
+ * @ingroup var
+ */
+#define v_refs_str(x) (*(uint32_t *)((x)->v.p.ptr - V_REFS_SIZE))
+
+/**
+ * @ingroup var
+ *
+ * the elements of the array indexed by SEARCH. cleared when the elements
+ * may be written or are freed, which has the index rebuilt
+ */
+extern const void *v_indexed_data;
+
 /**
  *< returns the var_t pointer of the element i
  * on the array x. i is a zero-based, one dim, index.
+ * shared arrays are first copied and packed arrays are
+ * first converted to var_t elements.
+ * @ingroup var
+*/
+#define v_elem(var, i) \
+  (&(v_packed(var) || v_shared(var) || (var)->v.a.data == v_indexed_data ? \
+     v_array_data((var_t *)(var)) : (var)->v.a.data)[i])
+
+/**
+ *< returns a read-only var_t pointer of the element i
+ * on the array x. packed elements are assigned to tmp
+ * which is returned in place of the element, leaving
+ * the array packed.
  * @ingroup var
 */
-#define v_elem(var, i) &((var)->v.a.data[i])
+#define v_elem_get(var, i, tmp) \
+  (v_packed(var) ? (v_packed_get((var), (i), (tmp)), (tmp)) : &(var)->v.a.data[i])
 
 /**
  * < the number of the elements of the array (x)
@@ -411,19 +558,19 @@ void v_input2var(const char *str, var_t *var);
  * < the number of array dimensions (x)
  * @ingroup var
  */
-#define v_maxdim(x) ((x)->v.a.maxdim)
+#define v_maxdim(x) ((x)->v.a.dims->maxdim)
 
 /**
  * < the array lower bound of the given dimension (x)
  * @ingroup var
  */
-#define v_lbound(x, i) ((x)->v.a.lbound[i])
+#define v_lbound(x, i) ((x)->v.a.dims->lbound[i])
 
 /**
  * < the array upper bound of the given dimension (x)
  * @ingroup var
  */
-#define v_ubound(x, i) ((x)->v.a.ubound[i])
+#define v_ubound(x, i) ((x)->v.a.dims->ubound[i])
 
 /**
  * < the array data
@@ -437,6 +584,18 @@ void v_input2var(const char *str, var_t *var);
  */
 #define v_capacity(x) ((x)->v.a.capacity)
 
+/**
+ * < the array element storage, see V_PACKED_NONE
+ * @ingroup var
+ */
+#define v_packed(x) ((x)->packed)
+
+/**
+ * < the packed array data
+ * @ingroup var
+ */
+#define v_pdata(x) ((var_pack_t *)(x)->v.a.data)
+
 /**
  * @ingroup var
  *
@@ -37,6 +37,7 @@ void map_set_int(var_p_t base, const char *name, var_int_t n);
 char *map_to_str(const var_p_t var_p);
 void map_write(const var_p_t var_p, int method, intptr_t handle);
 void map_parse_str(const char *js, size_t len, var_p_t dest);
+void map_parse_file(var_p_t dest, int handle);
 void map_from_str(var_p_t var_p);
 void map_from_codearray(var_p_t var_p);
 
@@ -219,4 +219,5 @@
 #define ERR_PARAM_NUM           "Incorrect number of parameters: %d. Expected %d."
 #define ERR_PACK_TOO_MANY       "Too many values to unpack"
 #define ERR_PACK_TOO_FEW        "Need more than %d values to unpack"
+#define ERR_SORT_CHANGED        "SORT: Array changed by the USE expression"
 #define ERR_MEMORY              "Out of memory error"
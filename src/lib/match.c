@@ -46,6 +46,20 @@
 #ifdef USE_PCRE
 #include <pcre.h>
 #define OVECCOUNT 30            /* should be a multiple of 3 */
+#define REG_CACHE_SIZE 16
+
+/**
+ * compiled pattern, the cache is kept in most recently used order
+ */
+typedef struct reg_cache_t {
+  char *pattern;
+  int options;
+  pcre *re;
+  pcre_extra *extra;
+} reg_cache_t;
+
+static reg_cache_t reg_cache[REG_CACHE_SIZE];
+static int reg_cache_count = 0;
 #endif
 
 int reg_match_after_star(const char *p, char *t);
@@ -249,31 +263,93 @@ int reg_match_jk(const char *p, char *t) {
 /*
  */
 #ifdef USE_PCRE
-int reg_match_pcre(const char *p, char *t)
-{
-  pcre *re;
+/*
+ * releases the compiled pattern
+ */
+static void reg_cache_release(reg_cache_t *entry) {
+  if (entry->extra) {
+#ifdef PCRE_STUDY_JIT_COMPILE
+    pcre_free_study(entry->extra);
+#else
+    pcre_free(entry->extra);
+#endif
+  }
+  pcre_free(entry->re);
+  free(entry->pattern);
+}
+
+/*
+ * returns the compiled pattern, compiling it when not already cached
+ */
+static reg_cache_t *reg_cache_get(const char *p, int options) {
+  reg_cache_t entry;
   const char *error;
   int errofs;
+  int i;
 
-  re =
-  pcre_compile(p, (opt_usepcre == 2) ? PCRE_CASELESS : 0, &error, &errofs, NULL);
-  if (!re) {
-    rt_raise("REGULAR EXPRESSION SYNTAX ERROR (offset %d) -> %s", error, errofs);
+  for (i = 0; i < reg_cache_count; i++) {
+    if (reg_cache[i].options == options && strcmp(reg_cache[i].pattern, p) == 0) {
+      break;
+    }
+  }
+
+  if (i < reg_cache_count) {
+    entry = reg_cache[i];
+  } else {
+    entry.re = pcre_compile(p, options, &error, &errofs, NULL);
+    if (!entry.re) {
+      rt_raise("REGULAR EXPRESSION SYNTAX ERROR (offset %d) -> %s", errofs, error);
+      return NULL;
+    }
+#ifdef PCRE_STUDY_JIT_COMPILE
+    entry.extra = pcre_study(entry.re, PCRE_STUDY_JIT_COMPILE, &error);
+#else
+    entry.extra = pcre_study(entry.re, 0, &error);
+#endif
+    entry.pattern = strdup(p);
+    entry.options = options;
+    if (reg_cache_count < REG_CACHE_SIZE) {
+      i = reg_cache_count++;
+    } else {
+      // discard the least recently used
+      i = REG_CACHE_SIZE - 1;
+      reg_cache_release(&reg_cache[i]);
+    }
+  }
+
+  // move to the front
+  memmove(&reg_cache[1], &reg_cache[0], i * sizeof(reg_cache_t));
+  reg_cache[0] = entry;
+  return &reg_cache[0];
+}
+
+int reg_match_pcre(const char *p, char *t) {
+  reg_cache_t *entry = reg_cache_get(p, (opt_usepcre == 2) ? PCRE_CASELESS : 0);
+  if (!entry) {
     return reg_match_bad_pattern;
   }
-  else {
-    int rc;
-    int ovector[OVECCOUNT];
 
-    rc = pcre_exec(re, NULL, t, strlen(t), 0, 0, ovector, OVECCOUNT);
-    if (rc >= 0)
+  int ovector[OVECCOUNT];
+  int rc = pcre_exec(entry->re, entry->extra, t, strlen(t), 0, 0, ovector, OVECCOUNT);
+  if (rc >= 0) {
     return reg_match_valid;
   }
-
   return reg_match_literal_failure;
 }
 #endif
 
+/*
+ * releases the compiled patterns
+ */
+void reg_match_free(void) {
+#ifdef USE_PCRE
+  for (int i = 0; i < reg_cache_count; i++) {
+    reg_cache_release(&reg_cache[i]);
+  }
+  reg_cache_count = 0;
+#endif
+}
+
 /*
  */
 int reg_match(const char *p, char *t) {
@@ -66,4 +66,11 @@
  */
 int reg_match(const char *p, char *t);
 
+/**
+ * @ingroup str
+ *
+ * releases the compiled regular expressions cached by reg_match
+ */
+void reg_match_free(void);
+
 #endif
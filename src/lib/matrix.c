@@ -26,33 +26,96 @@
 #include "common/sys.h"
 #include "common/blib_math.h"
 
-// creates a matrix of the given size
-var_num_t **mat_create(int row, int col) {
-  var_num_t **m = (var_num_t **)malloc(sizeof(var_num_t *) * row);
-  int i;
-  for (i = 0; i < row; i++) {
-    m[i] = (var_num_t *)malloc(sizeof(var_num_t) * col);
-  }
+// block sizes used by mat_product(), sized to keep the active rows of
+// the right hand matrix within the data cache
+#define MAT_BLOCK_K 64
+#define MAT_BLOCK_J 256
 
-  return m;
+/*
+ * c_row += a0 * b0 + a1 * b1 + a2 * b2 + a3 * b3 over columns [j, j_end)
+ *
+ * unrolled by four columns so that the compiler is able to use packed
+ * (SSE2/NEON) arithmetic without needing vectorization of loops
+ */
+static inline void mat_axpy4(var_num_t *restrict c_row, const var_num_t *restrict b0,
+                             const var_num_t *restrict b1, const var_num_t *restrict b2,
+                             const var_num_t *restrict b3, var_num_t a0, var_num_t a1,
+                             var_num_t a2, var_num_t a3, int j, int j_end) {
+  for (; j + 4 <= j_end; j += 4) {
+    c_row[j + 0] += a0 * b0[j + 0] + a1 * b1[j + 0] + a2 * b2[j + 0] + a3 * b3[j + 0];
+    c_row[j + 1] += a0 * b0[j + 1] + a1 * b1[j + 1] + a2 * b2[j + 1] + a3 * b3[j + 1];
+    c_row[j + 2] += a0 * b0[j + 2] + a1 * b1[j + 2] + a2 * b2[j + 2] + a3 * b3[j + 2];
+    c_row[j + 3] += a0 * b0[j + 3] + a1 * b1[j + 3] + a2 * b2[j + 3] + a3 * b3[j + 3];
+  }
+  for (; j < j_end; j++) {
+    c_row[j] += a0 * b0[j] + a1 * b1[j] + a2 * b2[j] + a3 * b3[j];
+  }
 }
 
-// free an allocated matrix
-void mat_free(var_num_t **m, int n) {
-  int i;
-  for (i = 0; i < n; i++) {
-    free(m[i]);
+/*
+ * y += a * x over columns [j, j_end)
+ */
+static inline void mat_axpy(var_num_t *restrict y, const var_num_t *restrict x,
+                            var_num_t a, int j, int j_end) {
+  for (; j + 4 <= j_end; j += 4) {
+    y[j + 0] += a * x[j + 0];
+    y[j + 1] += a * x[j + 1];
+    y[j + 2] += a * x[j + 2];
+    y[j + 3] += a * x[j + 3];
+  }
+  for (; j < j_end; j++) {
+    y[j] += a * x[j];
   }
-  free(m);
 }
 
-// fill the matrix with zero values
-void mat_fill(var_num_t **A, int row, int col) {
-  int i, j;
+/*
+ * y -= sum(a[i] * rows[i]) for i in [first, last), where rows[i] is the
+ * i-th row of the n x n matrix m
+ */
+static void mat_row_update(var_num_t *restrict y, const var_num_t *a,
+                           const var_num_t *m, int first, int last, int n) {
+  int i = first;
+  for (; i + 4 <= last; i += 4) {
+    mat_axpy4(y, m + i * n, m + (i + 1) * n, m + (i + 2) * n, m + (i + 3) * n,
+              -a[i], -a[i + 1], -a[i + 2], -a[i + 3], 0, n);
+  }
+  for (; i < last; i++) {
+    mat_axpy(y, m + i * n, -a[i], 0, n);
+  }
+}
 
-  for (i = 0; i < row; i++) {
-    for (j = 0; j < col; j++) {
-      A[i][j] = 0.0;
+/*
+ *-----------------------------------------------------------------------------
+ *       funct:  mat_product
+ *       desct:  matrix multiplication C = A * B
+ *       given:  A = matrix (rows x inner)
+ *               B = matrix (inner x cols)
+ *               C = result matrix (rows x cols)
+ *       comen:  runs in i-k-j order over blocks of B, so that each
+ *               step is a unit stride update of a row of C using four
+ *               rows of B while they remain in the data cache
+ *-----------------------------------------------------------------------------
+ */
+void mat_product(const var_num_t *restrict a, const var_num_t *restrict b,
+                 var_num_t *restrict c, int rows, int inner, int cols) {
+  memset(c, 0, sizeof(var_num_t) * rows * cols);
+  for (int jj = 0; jj < cols; jj += MAT_BLOCK_J) {
+    int j_end = I2MIN(jj + MAT_BLOCK_J, cols);
+    for (int kk = 0; kk < inner; kk += MAT_BLOCK_K) {
+      int k_end = I2MIN(kk + MAT_BLOCK_K, inner);
+      for (int i = 0; i < rows; i++) {
+        var_num_t *restrict c_row = c + i * cols;
+        const var_num_t *a_row = a + i * inner;
+        int k = kk;
+        for (; k + 4 <= k_end; k += 4) {
+          mat_axpy4(c_row, b + k * cols, b + (k + 1) * cols, b + (k + 2) * cols,
+                    b + (k + 3) * cols, a_row[k], a_row[k + 1], a_row[k + 2],
+                    a_row[k + 3], jj, j_end);
+        }
+        for (; k < k_end; k++) {
+          mat_axpy(c_row, b + k * cols, a_row[k], jj, j_end);
+        }
+      }
     }
   }
 }
@@ -61,150 +124,138 @@ void mat_fill(var_num_t **A, int row, int col) {
  *-----------------------------------------------------------------------------
  *       funct:  mat_lu
  *       desct:  in-place LU decomposition with partial pivoting
- *       given:  !! A = square matrix (n x n) !ATTENTION! see commen
- *               P = permutation vector (n x 1)
- *       retrn:  number of permutation performed
+ *       given:  A = square matrix (n x n)
+ *               P = permutation vector (n)
+ *       retrn:  number of row exchanges performed
  *               -1 means suspected singular matrix
  *       comen:  A will be overwritten to be a LU-composite matrix
- *
- *       note:   the LU decomposed may NOT be equal to the LU of
- *               the orignal matrix a. But equal to the LU of the
- *               rows interchanged matrix.
+ *               with the rows exchanged as recorded in P
  *-----------------------------------------------------------------------------
  */
-int mat_lu(var_num_t **A, var_num_t **P, int n) {
-  int i, j, k, maxi, tmp, p;
-  var_num_t c, c1;
+int mat_lu(var_num_t *a, int *p, int n) {
+  int swaps = 0;
 
-  for (p = 0, i = 0; i < n; i++) {
-    P[i][0] = i;
+  for (int i = 0; i < n; i++) {
+    p[i] = i;
   }
 
-  for (k = 0; k < n; k++) {
-    /*
-     * --- partial pivoting ---
-     */
-    for (i = k, maxi = k, c = 0.0; i < n; i++) {
-      c1 = fabsl(A[(int) P[i][0]][k]);
+  for (int k = 0; k < n; k++) {
+    // partial pivoting
+    int maxi = k;
+    var_num_t c = 0.0;
+    for (int i = k; i < n; i++) {
+      var_num_t c1 = fabs(a[i * n + k]);
       if (c1 > c) {
         c = c1;
         maxi = i;
       }
     }
 
-    /*
-     * row exchange, update permutation vector
-     */
+    // row exchange, update permutation vector
     if (k != maxi) {
-      p++;
-      tmp = P[k][0];
-      P[k][0] = P[maxi][0];
-      P[maxi][0] = tmp;
+      var_num_t *restrict row_k = a + k * n;
+      var_num_t *restrict row_m = a + maxi * n;
+      var_num_t swp;
+      int tmp;
+      for (int j = 0; j < n; j++) {
+        SWAP(row_k[j], row_m[j], swp);
+      }
+      SWAP(p[k], p[maxi], tmp);
+      swaps++;
     }
 
-    /*
-     * suspected singular matrix
-     */
-    if (A[(int) P[k][0]][k] == 0.0) {
+    // suspected singular matrix
+    var_num_t pivot = a[k * n + k];
+    if (pivot == 0.0) {
       return -1;
     }
 
-    for (i = k + 1; i < n; i++) {
-      /*
-       * --- calculate m(i,j) ---
-       */
-      A[(int) P[i][0]][k] = A[(int) P[i][0]][k] / A[(int) P[k][0]][k];
-
-      /*
-       * --- elimination ---
-       */
-      for (j = k + 1; j < n; j++) {
-        A[(int) P[i][0]][j] -= A[(int) P[i][0]][k] * A[(int) P[k][0]][j];
-      }
+    // elimination
+    const var_num_t *restrict row_k = a + k * n;
+    for (int i = k + 1; i < n; i++) {
+      var_num_t *restrict row_i = a + i * n;
+      var_num_t m = row_i[k] / pivot;
+      row_i[k] = m;
+      mat_axpy(row_i, row_k, -m, k + 1, n);
     }
   }
 
-  return p;
+  return swaps;
 }
 
 /*
  *-----------------------------------------------------------------------------
- *       funct:  mat_backsubs1
- *       desct:  back substitution
- *       given:  A = square matrix A (LU composite)
- *               !! B = column matrix B (attention!, see comen)
- *               !! X = place to put the result of X
- *               P = Permutation vector (after calling mat_lu)
- *               xcol = column of x to put the result
- *       retrn:  column matrix X (of AX = B)
- *       comen:  B will be overwritten
+ *      funct:  mat_inv
+ *      desct:  find inverse of a matrix
+ *      given:  a = square matrix a
+ *      retrn:  square matrix Inverse(A)
+ *              a is unchanged when singular, or malloc() fails
+ *      comen:  solves LU * X = P * I using whole row updates of X
  *-----------------------------------------------------------------------------
  */
-var_num_t **mat_backsubs1(var_num_t **A, var_num_t **B, var_num_t **X, var_num_t **P, int xcol, int n) {
-  int i, j, k;
-  var_num_t sum;
+void mat_inverse(var_num_t *a, const int n) {
+  var_num_t *lu = (var_num_t *)malloc(sizeof(var_num_t) * n * n);
+  var_num_t *x = (var_num_t *)calloc(n * n, sizeof(var_num_t));
+  int *p = (int *)malloc(sizeof(int) * n);
 
-  for (k = 0; k < n; k++) {
-    for (i = k + 1; i < n; i++) {
-      B[(int) P[i][0]][0] -= A[(int) P[i][0]][k] * B[(int) P[k][0]][0];
-    }
-  }
+  if (lu && x && p) {
+    memcpy(lu, a, sizeof(var_num_t) * n * n);
+
+    // LU-decomposition, also check for singular matrix
+    if (mat_lu(lu, p, n) != -1) {
+      for (int i = 0; i < n; i++) {
+        x[i * n + p[i]] = 1.0;
+      }
 
-  X[n - 1][xcol] = B[(int) P[n - 1][0]][0] / A[(int) P[n - 1][0]][n - 1];
-  for (k = n - 2; k >= 0; k--) {
-    sum = 0.0;
-    for (j = k + 1; j < n; j++) {
-      sum += A[(int) P[k][0]][j] * X[j][xcol];
+      // forward substitution, L has a unit diagonal
+      for (int i = 1; i < n; i++) {
+        mat_row_update(x + i * n, lu + i * n, x, 0, i, n);
+      }
+
+      // back substitution
+      for (int k = n - 1; k >= 0; k--) {
+        var_num_t *x_k = x + k * n;
+        mat_row_update(x_k, lu + k * n, x, k + 1, n, n);
+        var_num_t d = lu[k * n + k];
+        for (int j = 0; j < n; j++) {
+          x_k[j] /= d;
+        }
+      }
+
+      memcpy(a, x, sizeof(var_num_t) * n * n);
     }
-    X[k][xcol] = (B[(int) P[k][0]][0] - sum) / A[(int) P[k][0]][k];
   }
 
-  return X;
+  // release memory
+  free(p);
+  free(x);
+  free(lu);
 }
 
 /*
  *-----------------------------------------------------------------------------
- *      funct:  mat_inv
- *      desct:  find inverse of a matrix
+ *      funct:  mat_determ
+ *      desct:  determinant of a matrix
  *      given:  a = square matrix a
- *      retrn:  square matrix Inverse(A)
- *              NULL = fails, singular matrix, or malloc() fails
+ *              toler = pivots not larger than toler are treated as zero
+ *      retrn:  product of the LU diagonal, negated for an odd
+ *              number of row exchanges
+ *      comen:  a will be overwritten
  *-----------------------------------------------------------------------------
  */
-void mat_inverse(var_num_t *a, const int n) {
-  var_num_t **A = mat_create(n, n);
-  var_num_t **B = mat_create(n, 1);
-  var_num_t **C = mat_create(n, n);
-  var_num_t **P = mat_create(n, 1);
-
-  int i, j;
-
-  // copy input matrix to working buffer
-  for (i = 0; i < n; i++) {
-    for (j = 0; j < n; j++) {
-      A[i][j] = a[i * n + j];
-    }
-  }
-
-  // LU-decomposition, also check for singular matrix
-  if (mat_lu(A, P, n) != -1) {
-    for (i = 0; i < n; i++) {
-      mat_fill(B, n, 1);
-      B[i][0] = 1.0;
-      mat_backsubs1(A, B, C, P, i, n);
-    }
-
-    // copy the result in C back to a
-    for (i = 0; i < n; i++) {
-      for (j = 0; j < n; j++) {
-        a[i * n + j] = C[i][j];
+var_num_t mat_determ(var_num_t *a, int n, double toler) {
+  var_num_t result = 0.0;
+  int *p = (int *)malloc(sizeof(int) * n);
+  if (p) {
+    int swaps = mat_lu(a, p, n);
+    if (swaps != -1) {
+      result = (swaps % 2) ? -1.0 : 1.0;
+      for (int k = 0; k < n && result != 0.0; k++) {
+        var_num_t pivot = a[k * n + k];
+        result = (fabs(pivot) > toler) ? result * pivot : 0.0;
       }
     }
+    free(p);
   }
-
-  // release memory
-  mat_free(P, n);
-  mat_free(C, n);
-  mat_free(B, n);
-  mat_free(A, n);
+  return result;
 }
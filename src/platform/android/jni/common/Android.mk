@@ -16,7 +16,6 @@ LOCAL_CFLAGS     := -DHAVE_CONFIG_H=1 -DLODEPNG_NO_COMPILE_CPP
 LOCAL_SRC_FILES  :=    \
     $(COMMON)/../lib/matrix.c    \
     $(COMMON)/../lib/match.c     \
-    $(COMMON)/../lib/jsmn.c      \
     $(COMMON)/../lib/lodepng.c   \
     $(COMMON)/../lib/xpm.c       \
     $(COMMON)/../lib/str.c       \
@@ -46,6 +45,7 @@ LOCAL_SRC_FILES  :=    \
     $(COMMON)/kw.c               \
     $(COMMON)/pfill.c            \
     $(COMMON)/plot.c             \
+    $(COMMON)/profile.c          \
     $(COMMON)/proc.c             \
     $(COMMON)/sberr.c            \
     $(COMMON)/scan.c             \
@@ -138,6 +138,9 @@ void dump_bytecode(FILE *output) {
     case kwTYPE_EVPOP:
       fprintf(output, "pop (l)eft");
       break;
+    case kwTYPE_EVOPR:
+      fprintf(output, "(l)eft = (r)esult");
+      break;
     case kwTYPE_EOC:
       fprintf(output, "end-of-command");
       break;
@@ -10,6 +10,7 @@
 #include "config.h"
 #include <getopt.h>
 #include "common/sbapp.h"
+#include "common/profile.h"
 #include "ui/kwp.h"
 
 // decompile handling
@@ -22,6 +23,9 @@ extern "C" {
 
 void console_init();
 
+// callgrind output file for --profile
+static char profile_file[OS_PATHNAME_SIZE + 1];
+
 static struct option OPTIONS[] = {
   {"verbose",        no_argument,       NULL, 'v'},
   {"keywords",       no_argument,       NULL, 'k'},
@@ -31,6 +35,7 @@ static struct option OPTIONS[] = {
   {"decompile",      optional_argument, NULL, 's'},
   {"option",         optional_argument, NULL, 'o'},
   {"cmd",            optional_argument, NULL, 'c'},
+  {"profile",        optional_argument, NULL, 'p'},
   {"stdin",          optional_argument, NULL, '-'},
   {"help",           optional_argument, NULL, 'h'},
   {0, 0, 0, 0}
@@ -235,7 +240,7 @@ bool process_options(int argc, char *argv[], char **runFile, bool *tmpFile) {
   bool result = true;
   while (result) {
     int option_index = 0;
-    int c = getopt_long(argc, argv, "vkfxm::s::o:c:h::", OPTIONS, &option_index);
+    int c = getopt_long(argc, argv, "vkfxm::s::o:c:p::h::", OPTIONS, &option_index);
     if (c == -1 && !option_index) {
       // no more options
       for (int i = 1; i < argc; i++) {
@@ -303,6 +308,10 @@ bool process_options(int argc, char *argv[], char **runFile, bool *tmpFile) {
         result = false;
       }
       break;
+    case 'p':
+      opt_profile = 1;
+      strlcpy(profile_file, optarg ? optarg : "callgrind.out", sizeof(profile_file));
+      break;
     default:
       show_help();
       result = false;
@@ -347,6 +356,7 @@ int main(int argc, char *argv[]) {
   opt_nosave = 1;
   opt_pref_height = 0;
   opt_pref_width = 0;
+  opt_profile = 0;
   opt_quiet = 1;
   opt_verbose = 0;
 
@@ -360,6 +370,13 @@ int main(int argc, char *argv[]) {
     getcwd(prev_cwd, sizeof(prev_cwd) - 1);
     sbasic_main(file);
     chdir(prev_cwd);
+    if (opt_profile) {
+      profile_print(stderr);
+      if (!profile_write(profile_file)) {
+        fprintf(stderr, "Failed to write profile: %s\n", profile_file);
+      }
+      profile_free();
+    }
     if (tmpFile) {
       unlink(file);
     }
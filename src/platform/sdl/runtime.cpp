@@ -1076,10 +1076,12 @@ void dumpVariables(socket_t socket) {
     stknode_t node = prog_stack[i];
     switch (node.type) {
     case kwTYPE_CRVAR:
-      // local variable
-      net_printf(socket, "[%d] ", count++);
-      pv_writevar(tvar[node.x.vdvar.vid], PV_NET, socket);
-      net_print(socket, "\n");
+      // local variables
+      for (int j = node.x.vframe.count - 1; j > -1; j--) {
+        net_printf(socket, "[%d] ", count++);
+        pv_writevar(&node.x.vframe.slots[j].var, PV_NET, socket);
+        net_print(socket, "\n");
+      }
       break;
     case kwFUNC:
     case kwPROC:
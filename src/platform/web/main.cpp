@@ -15,6 +15,16 @@
 #include <stdio.h>
 #include <string.h>
 
+#if !defined(_Win32)
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "common/sbapp.h"
 #include "common/device.h"
 #include "common/osd.h"
@@ -27,6 +37,27 @@ bool g_graphicText = true;
 struct MHD_Connection *g_connection;
 StringList g_cookies;
 
+// compiled program, invalidated when the file is modified
+struct CacheEntry {
+  CacheEntry(const char *path, struct stat &st, byte *bytecode) :
+    _path(path),
+    _mtime(st.st_mtime),
+    _size(st.st_size),
+    _bytecode(bytecode) {
+  }
+  virtual ~CacheEntry() {
+    free(_bytecode);
+  }
+  String _path;
+  time_t _mtime;
+  off_t _size;
+  byte *_bytecode;
+};
+
+// least recently used first
+strlib::List<CacheEntry *> g_cache;
+int g_cacheSize = 32;
+
 static struct option OPTIONS[] = {
   {"help",           no_argument,       NULL, 'h'},
   {"verbose",        no_argument,       NULL, 'v'},
@@ -39,6 +70,8 @@ static struct option OPTIONS[] = {
   {"graphic-text",   optional_argument, NULL, 'g'},
   {"max-time",       optional_argument, NULL, 't'},
   {"module",         optional_argument, NULL, 'm'},
+  {"cache",          required_argument, NULL, 'a'},
+  {"workers",        required_argument, NULL, 'k'},
   {0, 0, 0, 0}
 };
 
@@ -105,6 +138,62 @@ int accept_cb(void *cls,
   return MHD_YES;
 }
 
+// returns the cached bytecode for the given program, compiling the program when
+// it is not in the cache or the file has changed since it was compiled. only the
+// program file is checked for changes, so programs using INCLUDE or IMPORT are
+// compiled for each request and the result is also returned in uncached for the
+// caller to free
+const byte *get_bytecode(const char *bas, byte **uncached) {
+  struct stat st;
+  *uncached = NULL;
+  if (g_cacheSize < 1 || stat(bas, &st) != 0) {
+    return NULL;
+  }
+
+  List_each(CacheEntry *, it, g_cache) {
+    CacheEntry *entry = (*it);
+    if (strcmp(entry->_path.c_str(), bas) == 0) {
+      g_cache.remove(it);
+      if (entry->_mtime == st.st_mtime && entry->_size == st.st_size) {
+        // move to the most recently used position
+        g_cache.add(entry);
+        if (opt_verbose) {
+          log("cache hit: %s", bas);
+        }
+        return entry->_bytecode;
+      }
+      delete entry;
+      break;
+    }
+  }
+
+  int depends;
+  byte *bytecode = sbasic_main_compile(bas, &depends);
+  if (bytecode == NULL) {
+    return NULL;
+  }
+  if (depends) {
+    if (opt_verbose) {
+      log("cache skip: %s uses INCLUDE or IMPORT", bas);
+    }
+    *uncached = bytecode;
+    return bytecode;
+  }
+  if (opt_verbose) {
+    log("cache miss: %s", bas);
+  }
+  if (g_cache.size() >= g_cacheSize) {
+    CacheEntry *oldest = g_cache[0];
+    g_cache.remove(g_cache.begin());
+    if (opt_verbose) {
+      log("cache evict: %s", oldest->_path.c_str());
+    }
+    delete oldest;
+  }
+  g_cache.add(new CacheEntry(bas, st, bytecode));
+  return bytecode;
+}
+
 MHD_Response *execute(struct MHD_Connection *connection, const char *bas) {
   const char *width =
     MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "width");
@@ -131,13 +220,21 @@ MHD_Response *execute(struct MHD_Connection *connection, const char *bas) {
   }
 
   log("%s dim:%dX%d", bas, os_graf_mx, os_graf_my);
+  byte *uncached;
+  const byte *bytecode = get_bytecode(bas, &uncached);
   g_connection = connection;
   g_canvas.reset();
   g_start = dev_get_millisecond_count();
   g_canvas.setGraphicText(g_graphicText);
   g_canvas.setJSON((strncmp(accept, "application/json", 16) == 0));
   g_cookies.removeAll();
-  sbasic_main(bas);
+  if (bytecode != NULL) {
+    sbasic_main_bc(bas, bytecode);
+  } else {
+    // cache disabled or compile errors to report
+    sbasic_main(bas);
+  }
+  free(uncached);
   g_connection = NULL;
   String page = g_canvas.getPage();
   MHD_Response *response =
@@ -231,14 +328,118 @@ int access_cb(void *cls,
   return result;
 }
 
+#if !defined(_Win32)
+// serves requests from the shared listening socket until terminated
+void run_worker(int fd) {
+  MHD_Daemon *d =
+    MHD_start_daemon(MHD_USE_SELECT_INTERNALLY, 0,
+                     &accept_cb, NULL,
+                     &access_cb, NULL,
+                     MHD_OPTION_LISTEN_SOCKET, fd,
+                     MHD_OPTION_END);
+  if (d == NULL) {
+    fprintf(stderr, "worker startup failed\n");
+    exit(1);
+  }
+  while (1) {
+    pause();
+  }
+}
+
+pid_t fork_worker(int fd) {
+  // the worker would otherwise repeat any buffered log output
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    run_worker(fd);
+  }
+  return pid;
+}
+
+// each worker is a separate process with its own interpreter state. workers
+// which exit, for example after a fatal error, or which could not be forked
+// are replaced once a second
+bool start_workers(int port, int count) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd == -1) {
+    return false;
+  }
+  int on = 1;
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+      listen(fd, SOMAXCONN) == -1) {
+    close(fd);
+    return false;
+  }
+  // workers compete to accept each connection
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  pid_t *pids = (pid_t *)malloc(sizeof(pid_t) * count);
+  for (int i = 0; i < count; i++) {
+    pids[i] = fork_worker(fd);
+  }
+
+  // run until input is received
+  struct pollfd in;
+  in.fd = STDIN_FILENO;
+  in.events = POLLIN;
+  in.revents = 0;
+  while (poll(&in, 1, 1000) < 1 || !(in.revents & (POLLIN | POLLHUP))) {
+    pid_t pid;
+    int status;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+      for (int i = 0; i < count; i++) {
+        if (pids[i] == pid) {
+          if (WIFSIGNALED(status)) {
+            log("worker %d killed by signal %d", pid, WTERMSIG(status));
+          } else {
+            log("worker %d exited with %d", pid, WEXITSTATUS(status));
+          }
+          pids[i] = -1;
+        }
+      }
+    }
+    for (int i = 0; i < count; i++) {
+      if (pids[i] == -1) {
+        pids[i] = fork_worker(fd);
+        if (pids[i] == -1) {
+          log("worker fork failed");
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (pids[i] > 0) {
+      kill(pids[i], SIGTERM);
+      waitpid(pids[i], NULL, 0);
+    }
+  }
+  free(pids);
+  close(fd);
+  return true;
+}
+#else
+bool start_workers(int port, int count) {
+  fprintf(stderr, "workers not supported\n");
+  return false;
+}
+#endif
+
 int main(int argc, char **argv) {
   init();
   int port = 8080;
+  int workers = 0;
   char *runBas = NULL;
 
   while (1) {
     int option_index = 0;
-    int c = getopt_long(argc, argv, "hvfp:t:m::r:w:e:c:g:", OPTIONS, &option_index);
+    int c = getopt_long(argc, argv, "hvfp:t:m::r:w:e:c:g:a:k:", OPTIONS, &option_index);
     if (c == -1) {
       break;
     }
@@ -285,6 +486,12 @@ int main(int argc, char **argv) {
         strcpy(opt_modpath, optarg);
       }
       break;
+    case 'a':
+      g_cacheSize = atoi(optarg);
+      break;
+    case 'k':
+      workers = atoi(optarg);
+      break;
     default:
       show_help();
       exit(1);
@@ -297,6 +504,12 @@ int main(int argc, char **argv) {
     g_start = dev_get_millisecond_count();
     sbasic_main(runBas);
     puts(g_canvas.getPage().c_str());
+  } else if (workers > 0) {
+    fprintf(stdout, "Starting SmallBASIC web server on port:%d workers:%d\n", port, workers);
+    if (!start_workers(port, workers)) {
+      fprintf(stderr, "startup failed\n");
+      return 1;
+    }
   } else {
     fprintf(stdout, "Starting SmallBASIC web server on port:%d\n", port);
     MHD_Daemon *d =